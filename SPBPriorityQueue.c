@@ -1,39 +1,129 @@
 #include "SPBPriorityQueue.h"
+#include "SPBPriorityQueueInternal.h"
 #include "SPList.h"
+#include "SPListElementInternal.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <float.h>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #define DEFAULT_INVALID_NUMBER -1
 
+// Updates a statistics counter of a queue, compiled out unless SP_BPQUEUE_STATS is defined
+#ifdef SP_BPQUEUE_STATS
+#define SP_BPQUEUE_STAT(source, update) ((source)->stats.update)
+#else
+#define SP_BPQUEUE_STAT(source, update) ((void) 0)
+#endif
+
+/*
+ * A structure used to count the queue operations, see SPBPQueueStats
+ * totalInsertPosition - the sum of the positions of the inserted elements, or of the heap
+ *                       levels they moved up, see SPBPQueueStats
+ */
+typedef struct sp_bp_queue_counters_t {
+	long enqueueAttempts;
+	long fastRejects;
+	long inserts;
+	long evictions;
+	long totalInsertPosition;
+	int peakSize;
+} SPBPQueueCounters;
+
+/*
+ * The operations of a queue backend, the queue functions check their arguments and
+ * the capacity and dispatch to them
+ * create - allocates the storage of a new empty queue, returns false on allocation error
+ * copy - allocates the storage of a new queue holding the items of source, returns false
+ *        on allocation error
+ * destroy - frees the storage of a queue, which may be partially created
+ * clear - removes all the items
+ * size - the number of items
+ * rejects - returns true iff an item must not enter the queue, because the queue is full
+ *           and the item is not smaller than its maximal item
+ * insert - inserts an item which was not rejected, the maximal item of a full queue is
+ *          evicted. SP_BPQUEUE_FULL if the backend finds it must be rejected after all
+ * removeMin - removes the minimal item of a non empty queue
+ * min, max - the minimal and the maximal items owned by the queue, NULL if it is empty
+ *            max does not reorder the items, it is read after every enqueue by the search
+ */
+typedef struct sp_bp_queue_backend_ops_t {
+	bool (*create)(SPBPQueue queue);
+	bool (*copy)(SPBPQueue queue, SPBPQueue source);
+	void (*destroy)(SPBPQueue queue);
+	void (*clear)(SPBPQueue queue);
+	int (*size)(SPBPQueue queue);
+	bool (*rejects)(SPBPQueue queue, SPListElement element);
+	SP_BPQUEUE_MSG (*insert)(SPBPQueue queue, SPListElement element);
+	void (*removeMin)(SPBPQueue queue);
+	SPListElement (*min)(SPBPQueue queue);
+	SPListElement (*max)(SPBPQueue queue);
+} SPBPQueueBackendOps;
+
 /*
  * A structure used in order to handle the queue data type
- * maxElement - a list element representing the maximum element in the queue
+ * ops - the operations of the backend of the queue
+ * backend - the backend of the queue
  * capacity - an integer representing a size limit for the queue
- * queue - a list used to store the queue items
+ * maxElement - a list element representing the maximum element in the queue (SP_BPQUEUE_LIST)
+ * queue - a list used to store the queue items (SP_BPQUEUE_LIST)
+ * items - capacity items stored by value, the array of the SP_BPQUEUE_MIN_MAX_HEAP backend
+ * size - the number of items in the array
+ * values, indices - the values and the indices of the items of the SP_BPQUEUE_SORTED_ARRAY
+ *                   backend, sorted, the items are at positions first to first + size - 1
+ * first - the position of the minimal item in values and indices
+ * minItem, maxItem - the minimal and maximal items of the sorted array, as returned by its
+ *                    min and max operations
+ * sorted - the number of items of the sorted prefix of a SP_BPQUEUE_LAZY queue, which
+ *          starts at position first, the other items are in its heap
+ * stats - the operation counters, only when compiled with SP_BPQUEUE_STATS
  */
 struct sp_bp_queue_t {
-	SPListElement maxElement;
+	const SPBPQueueBackendOps* ops;
+	SP_BPQUEUE_BACKEND backend;
 	int capacity;
+	SPListElement maxElement;
 	SPList queue;
+	struct sp_list_element_t* items;
+	int size;
+	double* values;
+	int* indices;
+	int first;
+	struct sp_list_element_t minItem;
+	struct sp_list_element_t maxItem;
+	int sorted;
+#ifdef SP_BPQUEUE_STATS
+	SPBPQueueCounters stats;
+#endif
 };
 
+static const SPBPQueueBackendOps* spBPQueueGetBackendOps(SP_BPQUEUE_BACKEND backend);
+
 
 /**
  * Allocates a new queue.
  * This function creates a new empty queue,
- * Using a flag regarding the creation of the internal data list, if the flag is on
- * the method will create a new list, otherwise it will use a copy of the given source queue
+ * Using a flag regarding the creation of the internal data, if the flag is on
+ * the method will create new storage, otherwise it will use a copy of the given source queue
  * @param maxSize - a limit for the size of the queue
+ * @param backend - the backend of the queue
  * @param source_queue - the given queue, this parameter should be NULL if the createNewList flag is on
- * @param createNewList - a flag used to indicate whether to create the internal list
+ * @param createNewList - a flag used to indicate whether to create the internal storage
  * @return
  * 	NULL - If allocations failed or maxSize < 0 or createNewList flag is off and source_queue is NULL
  * 	A new queue in case of success, with respect to the createNewList flag
  */
-SPBPQueue spBPQueueCreateWrapper(int maxSize, SPBPQueue source_queue, bool createNewList) {
+SPBPQueue spBPQueueCreateWrapper(int maxSize, SP_BPQUEUE_BACKEND backend, SPBPQueue source_queue,
+		bool createNewList) {
 	SPBPQueue newQueue;
+	bool created;
 
-	if (maxSize < 0)
+	if (maxSize < 0 || spBPQueueGetBackendOps(backend) == NULL)
+		return NULL;
+	if (!createNewList && source_queue == NULL)
 		return NULL;
 
 	newQueue = (SPBPQueue)calloc(1,sizeof(struct sp_bp_queue_t));
@@ -42,63 +132,63 @@ SPBPQueue spBPQueueCreateWrapper(int maxSize, SPBPQueue source_queue, bool creat
 		return NULL;
 
 	newQueue->capacity = maxSize;
+	newQueue->backend = backend;
+	newQueue->ops = spBPQueueGetBackendOps(backend);
 
+	if (createNewList)
+		created = newQueue->ops->create(newQueue);
+	else
+		created = newQueue->ops->copy(newQueue, source_queue);
 
-	if (createNewList) {
-		newQueue->queue = spListCreate();
-		newQueue->maxElement = NULL;
-	}
-	else {
-		newQueue->queue = spListCopy(source_queue->queue);
-		newQueue->maxElement = spListElementCopy(source_queue->maxElement);
-	}
-
-	//allocation error, or given source queue is NULL and createNewList if false
-	if (newQueue->queue == NULL)
+	if (!created) { //allocation error
+		spBPQueueDestroy(newQueue);
 		return NULL;
+	}
 
 	return newQueue;
 }
 
 SPBPQueue spBPQueueCreate(int maxSize) {
+	return spBPQueueCreateWithBackend(maxSize, maxSize <= SP_BPQUEUE_SORTED_ARRAY_MAX_SIZE
+			? SP_BPQUEUE_SORTED_ARRAY : SP_BPQUEUE_LIST);
+}
+
+SPBPQueue spBPQueueCreateWithBackend(int maxSize, SP_BPQUEUE_BACKEND backend) {
 	if (maxSize < 0)
 		return NULL;
 
-	return spBPQueueCreateWrapper(maxSize, NULL, true);
+	return spBPQueueCreateWrapper(maxSize, backend, NULL, true);
 }
 
 SPBPQueue spBPQueueCopy(SPBPQueue source) {
 	if (source == NULL)
 		return NULL;
 
-	return spBPQueueCreateWrapper(source->capacity, source , false);
+	return spBPQueueCreateWrapper(source->capacity, source->backend, source, false);
 }
 
 void spBPQueueDestroy(SPBPQueue source) {
 	if (source != NULL) {
-		if (source->queue != NULL)
-			spListDestroy(source->queue);
-		spListElementDestroy(source->maxElement);
-		source->maxElement = NULL;
+		source->ops->destroy(source);
 		free(source);
 		source = NULL;
 	}
 }
 
 void spBPQueueClear(SPBPQueue source) {
-	if (source != NULL && source->queue != NULL) {
-		spListClear(source->queue);
-		if (source->maxElement) {
-			spListElementDestroy(source->maxElement);
-			source->maxElement = NULL;
-		}
-	}
+	if (source != NULL)
+		source->ops->clear(source);
+}
+
+SP_BPQUEUE_BACKEND spBPQueueGetBackend(SPBPQueue source) {
+	assert(source != NULL);
+	return source->backend;
 }
 
 int spBPQueueSize(SPBPQueue source) {
-	if(source == NULL || source->queue == NULL)
+	if(source == NULL)
 		return DEFAULT_INVALID_NUMBER;
-	return spListGetSize(source->queue);
+	return source->ops->size(source);
 }
 
 int spBPQueueGetMaxSize(SPBPQueue source) {
@@ -156,6 +246,7 @@ SP_BPQUEUE_MSG spBPQueueHandleFullCapacity(SPBPQueue source) {
 	// if we get here we assume we never reached the end of the list (meaning null)
 	// because we assume spBPQueueSize is valid
 	spListRemoveCurrent(source->queue);
+	SP_BPQUEUE_STAT(source, evictions++);
 
 	spListElementDestroy(source->maxElement);
 	source->maxElement = spListElementCopy(prevElemInQueue);
@@ -235,8 +326,9 @@ SP_BPQUEUE_MSG spBPQueueInsertNotEmptyButLast(SPBPQueue source, SPListElement el
 SP_BPQUEUE_MSG spBPQueueInsertNotEmpty(SPBPQueue source, SPListElement newElement) {
 	SPListElement currElemInQueue = spListGetFirst(source->queue);
 
-	while (currElemInQueue != NULL && spListElementCompare(currElemInQueue, newElement) <= 0) {
+	while (currElemInQueue != NULL && spListElementCompareInline(currElemInQueue, newElement) <= 0) {
 		currElemInQueue = spListGetNext(source->queue);
+		SP_BPQUEUE_STAT(source, totalInsertPosition++);
 	}
 
 	// currElemInQueue > newElement
@@ -249,19 +341,15 @@ SP_BPQUEUE_MSG spBPQueueInsertNotEmpty(SPBPQueue source, SPListElement newElemen
 	return spBPQueueInsertNotEmptyButLast(source, newElement);
 }
 
-SP_BPQUEUE_MSG spBPQueueEnqueue(SPBPQueue source, SPListElement element) {
-	if (source == NULL || source->queue == NULL || element == NULL)
-		return SP_BPQUEUE_INVALID_ARGUMENT;
-
-	if (spBPQueueGetMaxSize(source) == 0)
-		return SP_BPQUEUE_FULL;
-
-
-	// the list is full and the element is greater than all the current items
-	if (spBPQueueIsFull(source) && spListElementCompare(element, source->maxElement) >= 0) {
-		return SP_BPQUEUE_FULL;
-	}
-
+/*
+ * Inserts an element to a queue which has room for it or holds a larger maximal element
+ * Pre-assumptions:
+ * - source != NULL and source->list != NULL and element != NULL
+ * @return
+ *  SP_BPQUEUE_OUT_OF_MEMORY - in case of memory error
+ *  SP_BPQUEUE_SUCCESS - in case the item was successfully inserted to the queue
+ */
+SP_BPQUEUE_MSG spBPQueueInsert(SPBPQueue source, SPListElement element) {
 	if (spBPQueueIsEmpty(source))
 		return spBPQueueInsertIfEmpty(source,element);
 
@@ -269,80 +357,664 @@ SP_BPQUEUE_MSG spBPQueueEnqueue(SPBPQueue source, SPListElement element) {
 	return spBPQueueInsertNotEmpty(source, element);
 }
 
-SP_BPQUEUE_MSG spBPQueueDequeue(SPBPQueue source) {
-	SPListElement first;
-	SP_LIST_MSG actionStatus;
+// creates the list of a SP_BPQUEUE_LIST queue
+bool spBPQueueListCreate(SPBPQueue queue) {
+	queue->queue = spListCreate();
+	queue->maxElement = NULL;
+	return queue->queue != NULL;
+}
 
-	if (source == NULL)
-		return SP_BPQUEUE_INVALID_ARGUMENT;
+// copies the list and the maximal element of a SP_BPQUEUE_LIST queue
+bool spBPQueueListCopy(SPBPQueue queue, SPBPQueue source) {
+	queue->queue = spListCopy(source->queue);
+	queue->maxElement = spListElementCopy(source->maxElement);
+	return queue->queue != NULL && (source->maxElement == NULL || queue->maxElement != NULL);
+}
 
-	if (spBPQueueIsEmpty(source))
-		return SP_BPQUEUE_EMPTY;
+void spBPQueueListDestroy(SPBPQueue queue) {
+	if (queue->queue != NULL)
+		spListDestroy(queue->queue);
+	spListElementDestroy(queue->maxElement);
+	queue->maxElement = NULL;
+}
 
-	first = spListGetFirst(source->queue);
-	if (first == NULL)
-		return SP_BPQUEUE_EMPTY;
+void spBPQueueListClear(SPBPQueue queue) {
+	if (queue->queue != NULL) {
+		spListClear(queue->queue);
+		if (queue->maxElement) {
+			spListElementDestroy(queue->maxElement);
+			queue->maxElement = NULL;
+		}
+	}
+}
+
+int spBPQueueListSize(SPBPQueue queue) {
+	if (queue->queue == NULL)
+		return DEFAULT_INVALID_NUMBER;
+	return spListGetSize(queue->queue);
+}
 
+void spBPQueueListRemoveMin(SPBPQueue queue) {
+	spListGetFirst(queue->queue);
 	// if we have 1 items -> last is first -> we should free its pointer
-	if (spBPQueueSize(source) == 1) {
-		spListElementDestroy(source->maxElement);
-		source->maxElement = NULL;
+	if (spListGetSize(queue->queue) == 1) {
+		spListElementDestroy(queue->maxElement);
+		queue->maxElement = NULL;
 	}
+	spListRemoveCurrent(queue->queue);
+}
 
-	actionStatus = spListRemoveCurrent(source->queue);
+SPListElement spBPQueueListMin(SPBPQueue queue) {
+	return spListGetFirst(queue->queue);
+}
 
-	if (actionStatus != SP_LIST_SUCCESS)
-		return SP_BPQUEUE_EMPTY;
+SPListElement spBPQueueListMax(SPBPQueue queue) {
+	return queue->maxElement;
+}
 
+// rejects the elements which are not smaller than the maximal item of a full queue
+bool spBPQueueRejectsAboveMax(SPBPQueue queue, SPListElement element) {
+	return spBPQueueIsFull(queue) && spListElementCompareInline(element, queue->ops->max(queue)) >= 0;
+}
+
+static const SPBPQueueBackendOps spBPQueueListOps = {
+	spBPQueueListCreate, spBPQueueListCopy, spBPQueueListDestroy, spBPQueueListClear,
+	spBPQueueListSize, spBPQueueRejectsAboveMax, spBPQueueInsert, spBPQueueListRemoveMin, spBPQueueListMin, spBPQueueListMax
+};
+
+/*
+ * The SP_BPQUEUE_MIN_MAX_HEAP backend
+ * The items are a min-max heap: the items on the even levels of the binary tree
+ * (the root is level 0) are not greater than their descendants, and the items on the
+ * odd levels are not smaller than their descendants. The minimum is the root and the
+ * maximum is one of its children, and both are removed by sifting the last item.
+ */
+
+// returns true iff item a is smaller than item b, in the order of spListElementCompare
+static inline bool spBPQueueItemLess(const struct sp_list_element_t* a,
+		const struct sp_list_element_t* b) {
+	return a->value < b->value || (a->value == b->value && a->index < b->index);
+}
+
+static inline void spBPQueueItemSwap(struct sp_list_element_t* items, int i, int j) {
+	struct sp_list_element_t temp = items[i];
+	items[i] = items[j];
+	items[j] = temp;
+}
+
+// returns true iff position i of the heap is on a min (even) level
+static inline bool spBPQueueHeapIsMinLevel(int i) {
+	bool minLevel = true;
+	for (i = i + 1; i > 1; i >>= 1)
+		minLevel = !minLevel;
+	return minLevel;
+}
+
+/*
+ * moves the item at position i up through its grandparents, while it is smaller than
+ * them on min levels (isMin) or larger than them on max levels
+ * returns the number of levels the item moved up
+ */
+static int spBPQueueHeapBubbleUp(struct sp_list_element_t* items, int i, bool isMin) {
+	int grandparent, levels = 0;
+	while (i > 2) {
+		grandparent = ((i - 1) / 2 - 1) / 2;
+		if (isMin ? !spBPQueueItemLess(items + i, items + grandparent)
+				: !spBPQueueItemLess(items + grandparent, items + i))
+			break;
+		spBPQueueItemSwap(items, i, grandparent);
+		i = grandparent;
+		levels += 2;
+	}
+	return levels;
+}
+
+/*
+ * restores the heap after an item was appended at position i
+ * returns the number of levels the item moved up
+ */
+static int spBPQueueHeapPush(struct sp_list_element_t* items, int i) {
+	int parent;
+	bool isMin;
+	if (i == 0)
+		return 0;
+	parent = (i - 1) / 2;
+	isMin = spBPQueueHeapIsMinLevel(i);
+	// an item which does not fit the level of its parent moves to the levels of the parent
+	if (isMin ? spBPQueueItemLess(items + parent, items + i)
+			: spBPQueueItemLess(items + i, items + parent)) {
+		spBPQueueItemSwap(items, i, parent);
+		return 1 + spBPQueueHeapBubbleUp(items, parent, !isMin);
+	}
+	return spBPQueueHeapBubbleUp(items, i, isMin);
+}
+
+/*
+ * moves the item at position i down to its place among its descendants, the smallest
+ * (isMin) or the largest of its children and grandchildren takes its place
+ */
+static void spBPQueueHeapTrickleDown(struct sp_list_element_t* items, int size, int i) {
+	bool isMin = spBPQueueHeapIsMinLevel(i);
+	int first, last, best, j;
+	while (2 * i + 1 < size) {
+		best = 2 * i + 1;
+		// the children are 2i + 1 and 2i + 2, the grandchildren 4i + 3 to 4i + 6
+		first = 2 * i + 2;
+		last = 4 * i + 6 < size - 1 ? 4 * i + 6 : size - 1;
+		for (j = first; j <= last; j = j == 2 * i + 2 ? 4 * i + 3 : j + 1) {
+			if (isMin ? spBPQueueItemLess(items + j, items + best)
+					: spBPQueueItemLess(items + best, items + j))
+				best = j;
+		}
+		if (isMin ? !spBPQueueItemLess(items + best, items + i)
+				: !spBPQueueItemLess(items + i, items + best))
+			return;
+		spBPQueueItemSwap(items, i, best);
+		if (best <= 2 * i + 2) // a child is on the other kind of level and has no descendants to fix
+			return;
+		// the item which moved down to a grandchild may not fit below its new parent
+		if (isMin ? spBPQueueItemLess(items + (best - 1) / 2, items + best)
+				: spBPQueueItemLess(items + best, items + (best - 1) / 2))
+			spBPQueueItemSwap(items, best, (best - 1) / 2);
+		i = best;
+	}
+}
+
+// the position of the maximal item of a non empty heap
+static inline int spBPQueueHeapMaxPosition(SPBPQueue queue) {
+	if (queue->size <= 2)
+		return queue->size - 1;
+	return spBPQueueItemLess(queue->items + 1, queue->items + 2) ? 2 : 1;
+}
+
+// removes the item at position i of the heap, which is the minimum or the maximum
+static void spBPQueueHeapRemove(SPBPQueue queue, int i) {
+	queue->size--;
+	if (i == queue->size)
+		return;
+	queue->items[i] = queue->items[queue->size];
+	spBPQueueHeapTrickleDown(queue->items, queue->size, i);
+}
+
+// allocates the items array of the array backends
+bool spBPQueueArrayCreate(SPBPQueue queue) {
+	queue->size = 0;
+	queue->items = (struct sp_list_element_t*) malloc(sizeof(struct sp_list_element_t)
+			* (size_t) (queue->capacity > 0 ? queue->capacity : 1));
+	return queue->items != NULL;
+}
+
+bool spBPQueueArrayCopy(SPBPQueue queue, SPBPQueue source) {
+	if (!spBPQueueArrayCreate(queue))
+		return false;
+	memcpy(queue->items, source->items, sizeof(struct sp_list_element_t) * (size_t) source->size);
+	queue->size = source->size;
+	return true;
+}
+
+void spBPQueueArrayDestroy(SPBPQueue queue) {
+	free(queue->items);
+	queue->items = NULL;
+}
+
+void spBPQueueArrayClear(SPBPQueue queue) {
+	queue->size = 0;
+}
+
+int spBPQueueArraySize(SPBPQueue queue) {
+	return queue->size;
+}
+
+SP_BPQUEUE_MSG spBPQueueHeapInsert(SPBPQueue queue, SPListElement element) {
+	int levels;
+	if (queue->size == queue->capacity) {
+		spBPQueueHeapRemove(queue, spBPQueueHeapMaxPosition(queue));
+		SP_BPQUEUE_STAT(queue, evictions++);
+	}
+	queue->items[queue->size] = *element;
+	levels = spBPQueueHeapPush(queue->items, queue->size);
+	SP_BPQUEUE_STAT(queue, totalInsertPosition += levels);
+	(void) levels; // unused when the statistics are compiled out
+	queue->size++;
 	return SP_BPQUEUE_SUCCESS;
 }
 
-SPListElement spBPQueuePeek(SPBPQueue source) {
-	SPListElement first;
+void spBPQueueHeapRemoveMin(SPBPQueue queue) {
+	spBPQueueHeapRemove(queue, 0);
+}
 
-	if (source == NULL)
-		return NULL;
+SPListElement spBPQueueHeapMin(SPBPQueue queue) {
+	return queue->size == 0 ? NULL : queue->items;
+}
+
+SPListElement spBPQueueHeapMax(SPBPQueue queue) {
+	return queue->size == 0 ? NULL : queue->items + spBPQueueHeapMaxPosition(queue);
+}
 
-	first = spListGetFirst(source->queue);
+static const SPBPQueueBackendOps spBPQueueHeapOps = {
+	spBPQueueArrayCreate, spBPQueueArrayCopy, spBPQueueArrayDestroy, spBPQueueArrayClear,
+	spBPQueueArraySize, spBPQueueRejectsAboveMax, spBPQueueHeapInsert, spBPQueueHeapRemoveMin, spBPQueueHeapMin,
+	spBPQueueHeapMax
+};
+
+/*
+ * The SP_BPQUEUE_SORTED_ARRAY backend
+ * The values and the indices of the items are kept sorted in two arrays, the insertion
+ * position is found by comparing whole vectors of values to the inserted value, and the
+ * larger items are moved by memmove. A dequeue only advances the first position, the
+ * items are moved back to the beginning of the arrays when an insert needs room.
+ */
 
-	return spListElementCopy(first);
+/*
+ * The vector comparison of the position search
+ * AVX - 4 values, SSE2 - 2 values, otherwise a single value
+ * spBPQueueLessMask returns a bit per value of values[0 .. SP_BPQUEUE_LANES - 1], set iff
+ * it is smaller than the given value
+ */
+#if defined(__AVX__)
+#define SP_BPQUEUE_LANES 4
+static inline int spBPQueueLessMask(const double* values, __m256d value) {
+	return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values), value, _CMP_LT_OQ));
+}
+#define SP_BPQUEUE_BROADCAST(value) _mm256_set1_pd(value)
+typedef __m256d SPBPQueueVector;
+#elif defined(__SSE2__)
+#define SP_BPQUEUE_LANES 2
+static inline int spBPQueueLessMask(const double* values, __m128d value) {
+	return _mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(values), value));
+}
+#define SP_BPQUEUE_BROADCAST(value) _mm_set1_pd(value)
+typedef __m128d SPBPQueueVector;
+#else
+#define SP_BPQUEUE_LANES 1
+static inline int spBPQueueLessMask(const double* values, double value) {
+	return *values < value;
+}
+#define SP_BPQUEUE_BROADCAST(value) (value)
+typedef double SPBPQueueVector;
+#endif
+
+// the number of bits set in a mask of spBPQueueLessMask
+static inline int spBPQueueMaskCount(int mask) {
+	int count = 0;
+	for (; mask != 0; mask >>= 1)
+		count += mask & 1;
+	return count;
 }
 
-SPListElement spBPQueuePeekLast(SPBPQueue source) {
-	if (source == NULL)
+/*
+ * the position of an item among count sorted items, after the items which are not
+ * larger than it. As the values are sorted, the values smaller than the item are a
+ * prefix, and the search stops at the first vector which is not entirely in it.
+ */
+static inline int spBPQueueSortedPosition(const double* values, const int* indices, int count,
+		SPListElement element) {
+	SPBPQueueVector value = SP_BPQUEUE_BROADCAST(element->value);
+	int position = 0, mask = (1 << SP_BPQUEUE_LANES) - 1;
+
+	while (position + SP_BPQUEUE_LANES <= count && mask == (1 << SP_BPQUEUE_LANES) - 1) {
+		mask = spBPQueueLessMask(values + position, value);
+		position += spBPQueueMaskCount(mask);
+	}
+	while (position < count && values[position] < element->value)
+		position++;
+	// equal values are ordered by their indices
+	while (position < count && values[position] == element->value
+			&& indices[position] <= element->index)
+		position++;
+	return position;
+}
+
+bool spBPQueueSortedCreate(SPBPQueue queue) {
+	size_t slots = (size_t) (queue->capacity > 0 ? queue->capacity : 1);
+	queue->size = 0;
+	queue->first = 0;
+	queue->values = (double*) malloc(sizeof(double) * slots);
+	queue->indices = (int*) malloc(sizeof(int) * slots);
+	return queue->values != NULL && queue->indices != NULL;
+}
+
+bool spBPQueueSortedCopy(SPBPQueue queue, SPBPQueue source) {
+	if (!spBPQueueSortedCreate(queue))
+		return false;
+	memcpy(queue->values, source->values + source->first, sizeof(double) * (size_t) source->size);
+	memcpy(queue->indices, source->indices + source->first, sizeof(int) * (size_t) source->size);
+	queue->size = source->size;
+	return true;
+}
+
+void spBPQueueSortedDestroy(SPBPQueue queue) {
+	free(queue->values);
+	free(queue->indices);
+	queue->values = NULL;
+	queue->indices = NULL;
+}
+
+void spBPQueueSortedClear(SPBPQueue queue) {
+	queue->size = 0;
+	queue->first = 0;
+}
+
+SP_BPQUEUE_MSG spBPQueueSortedInsert(SPBPQueue queue, SPListElement element) {
+	double* values;
+	int* indices;
+	int position;
+
+	if (queue->size == queue->capacity) { // the maximal item is evicted
+		queue->size--;
+		SP_BPQUEUE_STAT(queue, evictions++);
+	}
+	if (queue->first + queue->size == queue->capacity) { // no room after the last item
+		memmove(queue->values, queue->values + queue->first, sizeof(double) * (size_t) queue->size);
+		memmove(queue->indices, queue->indices + queue->first, sizeof(int) * (size_t) queue->size);
+		queue->first = 0;
+	}
+	values = queue->values + queue->first;
+	indices = queue->indices + queue->first;
+	position = spBPQueueSortedPosition(values, indices, queue->size, element);
+	SP_BPQUEUE_STAT(queue, totalInsertPosition += position);
+	memmove(values + position + 1, values + position,
+			sizeof(double) * (size_t) (queue->size - position));
+	memmove(indices + position + 1, indices + position,
+			sizeof(int) * (size_t) (queue->size - position));
+	values[position] = element->value;
+	indices[position] = element->index;
+	queue->size++;
+	return SP_BPQUEUE_SUCCESS;
+}
+
+void spBPQueueSortedRemoveMin(SPBPQueue queue) {
+	queue->first++;
+	queue->size--;
+	if (queue->size == 0)
+		queue->first = 0;
+}
+
+SPListElement spBPQueueSortedMin(SPBPQueue queue) {
+	if (queue->size == 0)
 		return NULL;
-	return spListElementCopy(source->maxElement);
+	queue->minItem.value = queue->values[queue->first];
+	queue->minItem.index = queue->indices[queue->first];
+	return &queue->minItem;
+}
+
+SPListElement spBPQueueSortedMax(SPBPQueue queue) {
+	if (queue->size == 0)
+		return NULL;
+	queue->maxItem.value = queue->values[queue->first + queue->size - 1];
+	queue->maxItem.index = queue->indices[queue->first + queue->size - 1];
+	return &queue->maxItem;
+}
+
+static const SPBPQueueBackendOps spBPQueueSortedOps = {
+	spBPQueueSortedCreate, spBPQueueSortedCopy, spBPQueueSortedDestroy, spBPQueueSortedClear,
+	spBPQueueArraySize, spBPQueueRejectsAboveMax, spBPQueueSortedInsert, spBPQueueSortedRemoveMin, spBPQueueSortedMin,
+	spBPQueueSortedMax
+};
+
+/*
+ * The SP_BPQUEUE_LAZY backend
+ * The items are a sorted prefix, at positions first to first + sorted - 1 of the first
+ * capacity slots, and the items inserted since the queue was last read, kept in a binary
+ * max-heap in the next capacity slots. The maximum is the larger of the last prefix item
+ * and the root of the heap, so an insert into a full queue evicts it exactly, as the other
+ * backends do, in O(log capacity) and without sorting anything. The heap is sorted and
+ * merged into the prefix only when the minimum is needed, so a queue which is filled and
+ * then drained sorts its items once, and a queue read after every insert pays for the
+ * merge of one item, as a sorted array.
+ * The heap is followed by room for capacity items, used by the sort.
+ */
+
+// the binary max-heap of the items inserted since the queue was last settled
+static inline struct sp_list_element_t* spBPQueueLazyHeap(SPBPQueue queue) {
+	return queue->items + queue->capacity;
 }
 
 /*
- * The method returns an element value, given a queue and a
- * function pointer that extract some element from it
- * Pre Assumptions - if the source is not NULL than func(source) != NULL
- * @param source - the given queue to extract the data from
- * @param func - a function pointer that given a queue, extract some element from it
- * @return
- * DEFAULT_INVALID_DOUBLE if source is NULL, otherwise the func(source) value.
+ * moves the item at position i of a max-heap up, while it is larger than its parent
+ * returns the number of levels the item moved up
  */
-double returnValueFrom(SPBPQueue source, SPListElement (*func)(SPBPQueue)) {
-	SPListElement item;
-	double returnValue;
+static int spBPQueueLazySiftUp(struct sp_list_element_t* heap, int i) {
+	struct sp_list_element_t item = heap[i];
+	int parent, levels = 0;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (!spBPQueueItemLess(heap + parent, &item))
+			break;
+		heap[i] = heap[parent];
+		i = parent;
+		levels++;
+	}
+	heap[i] = item;
+	return levels;
+}
+
+// moves the item at position i of a max-heap of count items down below its larger children
+static void spBPQueueLazySiftDown(struct sp_list_element_t* heap, int count, int i) {
+	struct sp_list_element_t item = heap[i];
+	int child;
+
+	while ((child = 2 * i + 1) < count) {
+		if (child + 1 < count && spBPQueueItemLess(heap + child, heap + child + 1))
+			child++;
+		if (!spBPQueueItemLess(&item, heap + child))
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = item;
+}
+
+// the position of the first of count sorted items which is not smaller than item
+static inline int spBPQueueLowerBound(const struct sp_list_element_t* items, int count,
+		const struct sp_list_element_t* item) {
+	int low = 0, high = count, middle;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (spBPQueueItemLess(items + middle, item))
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+/*
+ * sorts the heap and merges it into the prefix, which is moved to the start of the items
+ * first. The merge goes from the largest items down, the prefix items above every heap
+ * item are found by a binary search and moved at once, and it stops once the heap items
+ * are placed, the smaller items of the prefix are already in their places.
+ */
+static void spBPQueueLazySettle(SPBPQueue queue) {
+	struct sp_list_element_t* heap = spBPQueueLazyHeap(queue);
+	int i = queue->sorted, j = queue->size - queue->sorted - 1, w = queue->size, low, count;
+
+	if (j < 0)
+		return;
+	spListElementSortItems(heap, j + 1, queue->items + 2 * queue->capacity);
+	if (queue->first > 0) {
+		memmove(queue->items, queue->items + queue->first,
+				sizeof(struct sp_list_element_t) * (size_t) queue->sorted);
+		queue->first = 0;
+	}
+	// the prefix items before i and the heap items up to j are left, w follows the free room
+	for (; j >= 0; j--) {
+		low = spBPQueueLowerBound(queue->items, i, heap + j);
+		count = i - low;
+		w -= count;
+		memmove(queue->items + w, queue->items + low, sizeof(struct sp_list_element_t) * (size_t) count);
+		i = low;
+		queue->items[--w] = heap[j];
+	}
+	queue->sorted = queue->size;
+}
+
+bool spBPQueueLazyCreate(SPBPQueue queue) {
+	queue->size = 0;
+	queue->first = 0;
+	queue->sorted = 0;
+	queue->items = (struct sp_list_element_t*) malloc(sizeof(struct sp_list_element_t)
+			* 3 * (size_t) (queue->capacity > 0 ? queue->capacity : 1));
+	return queue->items != NULL;
+}
+
+bool spBPQueueLazyCopy(SPBPQueue queue, SPBPQueue source) {
+	if (!spBPQueueLazyCreate(queue))
+		return false;
+	memcpy(queue->items, source->items + source->first,
+			sizeof(struct sp_list_element_t) * (size_t) source->sorted);
+	memcpy(spBPQueueLazyHeap(queue), spBPQueueLazyHeap(source),
+			sizeof(struct sp_list_element_t) * (size_t) (source->size - source->sorted));
+	queue->size = source->size;
+	queue->sorted = source->sorted;
+	return true;
+}
+
+void spBPQueueLazyClear(SPBPQueue queue) {
+	queue->size = 0;
+	queue->first = 0;
+	queue->sorted = 0;
+}
+
+SP_BPQUEUE_MSG spBPQueueLazyInsert(SPBPQueue queue, SPListElement element) {
+	struct sp_list_element_t* heap = spBPQueueLazyHeap(queue);
+	int count = queue->size - queue->sorted, levels;
+
+	if (queue->size == queue->capacity) { // the maximal item is evicted
+		if (count == 0 || (queue->sorted > 0
+				&& spBPQueueItemLess(heap, queue->items + queue->first + queue->sorted - 1))) {
+			queue->sorted--;
+			if (queue->sorted == 0)
+				queue->first = 0;
+		} else {
+			heap[0] = heap[--count];
+			spBPQueueLazySiftDown(heap, count, 0);
+		}
+		queue->size--;
+		SP_BPQUEUE_STAT(queue, evictions++);
+	}
+	heap[count] = *element;
+	levels = spBPQueueLazySiftUp(heap, count);
+	SP_BPQUEUE_STAT(queue, totalInsertPosition += levels);
+	(void) levels; // unused when the statistics are compiled out
+	queue->size++;
+	return SP_BPQUEUE_SUCCESS;
+}
+
+void spBPQueueLazyRemoveMin(SPBPQueue queue) {
+	spBPQueueLazySettle(queue);
+	queue->first++;
+	queue->size--;
+	queue->sorted--;
+	if (queue->size == 0)
+		queue->first = 0;
+}
+
+SPListElement spBPQueueLazyMin(SPBPQueue queue) {
+	spBPQueueLazySettle(queue);
+	return queue->size == 0 ? NULL : queue->items + queue->first;
+}
+
+// the larger of the last prefix item and the root of the heap, the queue is not settled
+SPListElement spBPQueueLazyMax(SPBPQueue queue) {
+	struct sp_list_element_t* last = queue->items + queue->first + queue->sorted - 1;
+
+	if (queue->size == queue->sorted)
+		return queue->size == 0 ? NULL : last;
+	if (queue->sorted == 0 || spBPQueueItemLess(last, spBPQueueLazyHeap(queue)))
+		return spBPQueueLazyHeap(queue);
+	return last;
+}
+
+static const SPBPQueueBackendOps spBPQueueLazyOps = {
+	spBPQueueLazyCreate, spBPQueueLazyCopy, spBPQueueArrayDestroy, spBPQueueLazyClear,
+	spBPQueueArraySize, spBPQueueRejectsAboveMax, spBPQueueLazyInsert, spBPQueueLazyRemoveMin,
+	spBPQueueLazyMin, spBPQueueLazyMax
+};
+
+// the operations of a backend, NULL if backend is not a SP_BPQUEUE_BACKEND
+static const SPBPQueueBackendOps* spBPQueueGetBackendOps(SP_BPQUEUE_BACKEND backend) {
+	switch (backend) {
+	case SP_BPQUEUE_LIST:
+		return &spBPQueueListOps;
+	case SP_BPQUEUE_MIN_MAX_HEAP:
+		return &spBPQueueHeapOps;
+	case SP_BPQUEUE_SORTED_ARRAY:
+		return &spBPQueueSortedOps;
+	case SP_BPQUEUE_LAZY:
+		return &spBPQueueLazyOps;
+	default:
+		return NULL;
+	}
+}
+
+SP_BPQUEUE_MSG spBPQueueEnqueue(SPBPQueue source, SPListElement element) {
+	SP_BPQUEUE_MSG retVal;
+
+	if (source == NULL || element == NULL || source->ops->size(source) < 0)
+		return SP_BPQUEUE_INVALID_ARGUMENT;
+
+	SP_BPQUEUE_STAT(source, enqueueAttempts++);
+
+	if (spBPQueueGetMaxSize(source) == 0) {
+		SP_BPQUEUE_STAT(source, fastRejects++);
+		return SP_BPQUEUE_FULL;
+	}
+
+
+	// the queue is full and the element is greater than all the current items
+	if (source->ops->rejects(source, element)) {
+		SP_BPQUEUE_STAT(source, fastRejects++);
+		return SP_BPQUEUE_FULL;
+	}
+
+	retVal = source->ops->insert(source, element);
+#ifdef SP_BPQUEUE_STATS
+	if (retVal == SP_BPQUEUE_SUCCESS) {
+		source->stats.inserts++;
+		if (spBPQueueSize(source) > source->stats.peakSize)
+			source->stats.peakSize = spBPQueueSize(source);
+	}
+#endif
+	return retVal;
+}
 
+SP_BPQUEUE_MSG spBPQueueDequeue(SPBPQueue source) {
 	if (source == NULL)
-		return DEFAULT_INVALID_NUMBER;
+		return SP_BPQUEUE_INVALID_ARGUMENT;
 
-	item = (*func)(source);
-	returnValue = spListElementGetValue(item);
-	spListElementDestroy(item);
+	if (spBPQueueSize(source) <= 0)
+		return SP_BPQUEUE_EMPTY;
 
-	return returnValue;
+	source->ops->removeMin(source);
+	return SP_BPQUEUE_SUCCESS;
+}
+
+SPListElement spBPQueuePeek(SPBPQueue source) {
+	if (source == NULL)
+		return NULL;
+
+	return spListElementCopy(source->ops->min(source));
+}
+
+SPListElement spBPQueuePeekLast(SPBPQueue source) {
+	if (source == NULL)
+		return NULL;
+	return spListElementCopy(source->ops->max(source));
 }
 
 double spBPQueueMinValue(SPBPQueue source) {
-	return returnValueFrom(source, &spBPQueuePeek);
+	if (source == NULL)
+		return DEFAULT_INVALID_NUMBER;
+	return spListElementGetValueInline(source->ops->min(source));
 }
 
 double spBPQueueMaxValue(SPBPQueue source) {
-	return returnValueFrom(source, &spBPQueuePeekLast);
+	if (source == NULL)
+		return DEFAULT_INVALID_NUMBER;
+	return spListElementGetValueInline(source->ops->max(source));
 }
 
 bool spBPQueueIsEmpty(SPBPQueue source) {
@@ -354,3 +1026,34 @@ bool spBPQueueIsFull(SPBPQueue source) {
 	assert(source);
 	return (spBPQueueSize(source) == spBPQueueGetMaxSize(source));
 }
+
+// the max operation of no backend reorders its items, see SPBPQueueBackendOps
+double spBPQueueThreshold(SPBPQueue source) {
+	assert(source);
+	if (!spBPQueueIsFull(source))
+		return DBL_MAX;
+	return spListElementGetValueInline(source->ops->max(source));
+}
+
+SP_BPQUEUE_MSG spBPQueueGetStats(SPBPQueue source, SPBPQueueStats* stats) {
+	if (source == NULL || stats == NULL)
+		return SP_BPQUEUE_INVALID_ARGUMENT;
+
+#ifdef SP_BPQUEUE_STATS
+	stats->enqueueAttempts = source->stats.enqueueAttempts;
+	stats->fastRejects = source->stats.fastRejects;
+	stats->inserts = source->stats.inserts;
+	stats->evictions = source->stats.evictions;
+	stats->averageInsertPosition = source->stats.inserts == 0 ? 0 :
+			(double) source->stats.totalInsertPosition / (double) source->stats.inserts;
+	stats->peakSize = source->stats.peakSize;
+#else
+	stats->enqueueAttempts = 0;
+	stats->fastRejects = 0;
+	stats->inserts = 0;
+	stats->evictions = 0;
+	stats->averageInsertPosition = 0;
+	stats->peakSize = 0;
+#endif
+	return SP_BPQUEUE_SUCCESS;
+}
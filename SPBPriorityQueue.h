@@ -14,9 +14,15 @@
  * The type also stores a pointer to the last element in the queue, which is also the largest one
  * if the queue is empty, the pointer is NULL
  *
+ * The items may be stored by other backends, chosen when the queue is created
+ * (see SP_BPQUEUE_BACKEND). All the backends hold the same items, so peeks, dequeues
+ * and sizes give the same results, and they differ in the cost of the operations.
+ *
  * The following functions are available:
  *
  *   spBPQueueCreate            - Creates a new empty queue, limited to the given maximum size
+ *   spBPQueueCreateWithBackend - Creates a new empty queue stored by the given backend
+ *   spBPQueueGetBackend        - Returns the backend of a given queue
  *   spBPQueueDestroy           - Deletes an existing queue and frees all resources
  *   spBPQueueCopy              - Copies an existing queue, with the same capacity
  *   spBPQueueClear             - Removes all the elements from the queue
@@ -32,6 +38,10 @@
  *   spBPQueueMaxValue          - Returns the value of the maximal item in the queue
  *   spBPQueueIsEmpty           - Returns true if and only if the queue is empty
  *   spBPQueueIsFull            - Returns true if and only if the queue is full
+ *   spBPQueueGetStats          - Returns the operation statistics of the queue
+ *
+ * The statistics are collected only when the queue is compiled with SP_BPQUEUE_STATS
+ * defined, otherwise the counting is compiled out and all statistics are 0.
  */
 
 
@@ -47,9 +57,62 @@ typedef enum sp_bp_queue_msg_t {
 	SP_BPQUEUE_SUCCESS
 } SP_BPQUEUE_MSG;
 
+/**
+ * type used to choose how the items of a queue are stored, k is the capacity
+ * SP_BPQUEUE_LIST - the sorted SPList, O(1) peeks and dequeue, O(k) enqueue
+ * SP_BPQUEUE_MIN_MAX_HEAP - a min-max heap array, O(1) peeks, O(log k) enqueue
+ *                           and dequeue, for queues which interleave dequeues and
+ *                           bounded enqueues
+ * SP_BPQUEUE_SORTED_ARRAY - sorted arrays of the values and the indices, O(1) peeks and
+ *                           dequeue, O(k) enqueue by a vectorised search and memmove,
+ *                           the fastest for small capacities
+ * SP_BPQUEUE_LAZY - a sorted prefix and a max-heap of the items enqueued since the
+ *                   minimum was last read, O(log k) enqueue and O(1) maximum, the heap
+ *                   is sorted and merged into the prefix only when the minimum is
+ *                   peeked or dequeued (O(k) for a read after every enqueue), for scans
+ *                   which read the queue rarely
+ */
+typedef enum sp_bp_queue_backend_t {
+	SP_BPQUEUE_LIST,
+	SP_BPQUEUE_MIN_MAX_HEAP,
+	SP_BPQUEUE_SORTED_ARRAY,
+	SP_BPQUEUE_LAZY
+} SP_BPQUEUE_BACKEND;
+
+/**
+ * The maximal capacity of the queues spBPQueueCreate stores in a SP_BPQUEUE_SORTED_ARRAY,
+ * up to which it enqueued faster than the list for every input order of sp_bench.
+ * The arrays are allocated for the whole capacity when the queue is created.
+ */
+#define SP_BPQUEUE_SORTED_ARRAY_MAX_SIZE 128
+
+/**
+ * type used to report the operation statistics of a queue
+ * enqueueAttempts - the number of valid spBPQueueEnqueue calls
+ * fastRejects - the number of elements rejected without a search, because the queue
+ *               was full and the element was not smaller than the maximal element
+ * inserts - the number of elements inserted to the queue
+ * evictions - the number of maximal elements removed to make room for an insert
+ * averageInsertPosition - the average number of elements preceding an inserted element,
+ *                         which is the number of elements probed by the insertion search
+ *                         (SP_BPQUEUE_LIST and SP_BPQUEUE_SORTED_ARRAY), or the average
+ *                         number of heap levels an inserted element moved up
+ *                         (SP_BPQUEUE_MIN_MAX_HEAP and SP_BPQUEUE_LAZY)
+ * peakSize - the maximal size the queue reached
+ */
+typedef struct sp_bp_queue_stats_t {
+	long enqueueAttempts;
+	long fastRejects;
+	long inserts;
+	long evictions;
+	double averageInsertPosition;
+	int peakSize;
+} SPBPQueueStats;
+
 /**
  * Allocates a new queue.
- * This function creates a new empty queue.
+ * This function creates a new empty queue, stored by SP_BPQUEUE_SORTED_ARRAY if
+ * maxSize <= SP_BPQUEUE_SORTED_ARRAY_MAX_SIZE and by SP_BPQUEUE_LIST otherwise.
  * @param maxSize - a limit for the size of the queue
  * @return
  * 	NULL - If allocations failed or maxSize < 0
@@ -57,6 +120,26 @@ typedef enum sp_bp_queue_msg_t {
  */
 SPBPQueue spBPQueueCreate(int maxSize);
 
+/**
+ * Allocates a new queue whose items are stored by the given backend.
+ * Copies of the queue have the same backend.
+ * @param maxSize - a limit for the size of the queue
+ * @param backend - the backend storing the items
+ * @return
+ * 	NULL - If allocations failed or maxSize < 0 or backend is not a SP_BPQUEUE_BACKEND
+ * 	A new queue in case of success.
+ */
+SPBPQueue spBPQueueCreateWithBackend(int maxSize, SP_BPQUEUE_BACKEND backend);
+
+/**
+ * Returns the backend storing the items of the queue
+ * @param source - The target which backend is requested.
+ * @assert source != NULL
+ * @return
+ * The backend of the queue
+ */
+SP_BPQUEUE_BACKEND spBPQueueGetBackend(SPBPQueue source);
+
 /**
  * Creates a copy of target queue.
  *
@@ -191,4 +274,17 @@ bool spBPQueueIsEmpty(SPBPQueue source);
  */
 bool spBPQueueIsFull(SPBPQueue source);
 
+/**
+ * Returns the operation statistics of the queue, counted since the queue was
+ * created (a copy of a queue starts with empty statistics, clearing a queue
+ * does not reset them).
+ * If the queue is compiled without SP_BPQUEUE_STATS all statistics are 0.
+ * @param source - The target which the statistics are requested on.
+ * @param stats - The statistics are written to stats
+ * @return
+ * SP_BPQUEUE_INVALID_ARGUMENT if source is NULL or stats is NULL
+ * SP_BPQUEUE_SUCCESS otherwise
+ */
+SP_BPQUEUE_MSG spBPQueueGetStats(SPBPQueue source, SPBPQueueStats* stats);
+
 #endif
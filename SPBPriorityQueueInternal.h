@@ -0,0 +1,25 @@
+#ifndef SPBPRIORITYQUEUEINTERNAL_H_
+#define SPBPRIORITYQUEUEINTERNAL_H_
+
+#include "SPBPriorityQueue.h"
+
+/**
+ * SPBPriorityQueue internal summary
+ *
+ * Exposes to the trusted modules of this library (the search code) the queue reads
+ * which their scan loops need after every enqueue, with no side effect on the storage
+ * of any backend. External users must include SPBPriorityQueue.h only.
+ */
+
+/**
+ * Returns the value an element must not exceed to enter the queue: the maximal value
+ * of a full queue, DBL_MAX before the queue is full.
+ * Unlike spBPQueueMaxValue, it never sorts the items of a SP_BPQUEUE_LAZY queue.
+ * @param source - The target which the check is requested on.
+ * @assert source != NULL
+ * @return
+ * the threshold of the queue
+ */
+double spBPQueueThreshold(SPBPQueue source);
+
+#endif /* SPBPRIORITYQUEUEINTERNAL_H_ */
@@ -0,0 +1,59 @@
+#define _POSIX_C_SOURCE 200112L
+#include "SPBinaryPointInternal.h"
+#include "SPDistance.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+SPBinaryPoint spBinaryPointCreate(const uint64_t* words, int bits, int index) {
+	void* block;
+	SPBinaryPoint item;
+	int count;
+
+	if (words == NULL || bits <= 0 || index < 0) //illegal arguments
+		return NULL;
+
+	count = spBinaryPointWordsCount(bits);
+	if (posix_memalign(&block, SP_BINARY_POINT_ALIGNMENT,
+			sizeof(struct sp_binary_point_t) + sizeof(uint64_t) * (size_t) count) != 0)
+		return NULL; //allocation error
+
+	item = (SPBinaryPoint) block;
+	item->bits = bits;
+	item->index = index;
+	memcpy(item->words, words, sizeof(uint64_t) * (size_t) count);
+	// the unused bits are cleared so they never count in a distance
+	if (bits % 64 != 0)
+		item->words[count - 1] &= (UINT64_C(1) << (bits % 64)) - 1;
+
+	return item;
+}
+
+SPBinaryPoint spBinaryPointCopy(SPBinaryPoint source) {
+	assert(source != NULL);
+	return spBinaryPointCreate(source->words, source->bits, source->index);
+}
+
+void spBinaryPointDestroy(SPBinaryPoint point) {
+	free(point);
+}
+
+int spBinaryPointGetBits(SPBinaryPoint point) {
+	assert(point != NULL);
+	return point->bits;
+}
+
+int spBinaryPointGetIndex(SPBinaryPoint point) {
+	assert(point != NULL);
+	return point->index;
+}
+
+bool spBinaryPointGetBit(SPBinaryPoint point, int bit) {
+	assert(point != NULL && bit >= 0 && bit < point->bits);
+	return (point->words[bit / 64] >> (bit % 64)) & 1;
+}
+
+int spBinaryPointHammingDistance(SPBinaryPoint p, SPBinaryPoint q) {
+	assert(p != NULL && q != NULL && p->bits == q->bits);
+	return spDistanceHamming(p->words, q->words, spBinaryPointWordsCount(p->bits));
+}
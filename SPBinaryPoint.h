@@ -0,0 +1,106 @@
+#ifndef SPBINARYPOINT_H_
+#define SPBINARYPOINT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * SPBinaryPoint Summary
+ * Encapsulates a binary descriptor of a variable number of bits, packed into
+ * 64 bit words, so a 256 bit descriptor takes 32 bytes instead of the 2048
+ * bytes of an SPPoint of dimension 256. As in SPPoint, each point has a
+ * non-negative index which represents the image index to which the point belongs.
+ * Bit i of the descriptor is bit (i % 64) of word i / 64, the bits of the last
+ * word beyond the number of bits are always 0.
+ *
+ * The following functions are supported:
+ *
+ * spBinaryPointCreate			- Creates a new binary point
+ * spBinaryPointCopy			- Create a new copy of a given binary point
+ * spBinaryPointDestroy			- Free all resources associated with a binary point
+ * spBinaryPointGetBits			- A getter of the number of bits of a binary point
+ * spBinaryPointGetIndex		- A getter of the index of a binary point
+ * spBinaryPointGetBit			- A getter of a given bit of a binary point
+ * spBinaryPointHammingDistance	- Calculates the Hamming distance between two binary points
+ */
+
+/** Type for defining the binary point **/
+typedef struct sp_binary_point_t* SPBinaryPoint;
+
+/**
+ * Allocates a new binary point in the memory.
+ * Given the packed words of a descriptor, its number of bits and an index,
+ * the bit i of the new point is bit (i % 64) of words[i / 64].
+ * The bits of the last word beyond bits are ignored.
+ *
+ * @param words - The packed descriptor, at least (bits + 63) / 64 words
+ * @param bits - The number of bits of the descriptor
+ * @param index - The index of the point
+ * @return
+ * NULL in case allocation failure ocurred OR words is NULL OR bits <= 0 OR index < 0
+ * Otherwise, the new binary point is returned
+ */
+SPBinaryPoint spBinaryPointCreate(const uint64_t* words, int bits, int index);
+
+/**
+ * Allocate a copy of the given binary point.
+ *
+ * @param source - The source binary point
+ * @assert (source != NULL)
+ * @return
+ * NULL in case memory allocation occurs
+ * Others a new copy of the source binary point is returned
+ */
+SPBinaryPoint spBinaryPointCopy(SPBinaryPoint source);
+
+/**
+ * Free all memory allocation associated with point,
+ * if point is NULL nothing happens.
+ */
+void spBinaryPointDestroy(SPBinaryPoint point);
+
+/**
+ * A getter for the number of bits of the binary point
+ *
+ * @param point - The source binary point
+ * @assert point != NULL
+ * @return
+ * The number of bits of the point
+ */
+int spBinaryPointGetBits(SPBinaryPoint point);
+
+/**
+ * A getter for the index of the binary point
+ *
+ * @param point - The source binary point
+ * @assert point != NULL
+ * @return
+ * The index of the point
+ */
+int spBinaryPointGetIndex(SPBinaryPoint point);
+
+/**
+ * A getter for a specific bit of the binary point
+ *
+ * @param point - The source binary point
+ * @param bit - The bit of the point which its value will be retrieved
+ * @assert point != NULL AND 0 <= bit < bits(point)
+ * @return
+ * The value of the given bit of the point
+ */
+bool spBinaryPointGetBit(SPBinaryPoint point, int bit);
+
+/**
+ * Calculates the Hamming distance between p and q, the number of bits in
+ * which they differ, by spDistanceHamming (POPCNT, or AVX-512 VPOPCNTDQ when
+ * the library is compiled with it).
+ *
+ * @param p - The first binary point
+ * @param q - The second binary point
+ * @assert p!=NULL AND q!=NULL AND bits(p) == bits(q)
+ * @return
+ * The Hamming distance between p and q
+ */
+int spBinaryPointHammingDistance(SPBinaryPoint p, SPBinaryPoint q);
+
+#endif /* SPBINARYPOINT_H_ */
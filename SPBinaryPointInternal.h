@@ -0,0 +1,38 @@
+#ifndef SPBINARYPOINTINTERNAL_H_
+#define SPBINARYPOINTINTERNAL_H_
+
+#include "SPBinaryPoint.h"
+#include <assert.h>
+#include <stdint.h>
+
+/**
+ * SPBinaryPoint internal summary
+ *
+ * Exposes the layout of SPBinaryPoint to the trusted modules of this library
+ * (the search code), so they can read the words of the points directly.
+ * External users must include SPBinaryPoint.h only, the layout is not part of the API.
+ */
+
+// The alignment of the block holding a binary point and its words, a cache line
+#define SP_BINARY_POINT_ALIGNMENT 64
+
+/*
+ * A structure used for the binary point data type
+ * The point is allocated as one SP_BINARY_POINT_ALIGNMENT aligned block, so the words of
+ * a descriptor of up to 448 bits share the cache line of the header.
+ * bits - the number of bits of the descriptor
+ * index - an integer representing the image index related to the point
+ * words - the packed descriptor, (bits + 63) / 64 words, the unused bits are 0
+ */
+struct sp_binary_point_t {
+	int bits;
+	int index;
+	uint64_t words[];
+};
+
+// the number of words of a descriptor of the given number of bits
+static inline int spBinaryPointWordsCount(int bits) {
+	return (bits + 63) / 64;
+}
+
+#endif /* SPBINARYPOINTINTERNAL_H_ */
@@ -0,0 +1,815 @@
+#include "SPDistance.h"
+#include <assert.h>
+#include <float.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+
+/*
+ * The half precision kernels use F16C when the library is compiled with it, and
+ * otherwise, with GCC or Clang on x86, an F16C variant compiled for its target
+ * which is chosen at run time if the processor supports it.
+ */
+#if defined(__F16C__) && defined(__AVX__)
+#define SP_DISTANCE_F16C
+#define SP_DISTANCE_F16C_TARGET
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SP_DISTANCE_F16C
+#define SP_DISTANCE_F16C_DISPATCH
+#define SP_DISTANCE_F16C_TARGET __attribute__((target("avx,f16c")))
+#endif
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(__AVX512VPOPCNTDQ__) || defined(SP_DISTANCE_F16C)
+#include <immintrin.h>
+#endif
+
+// The number of half precision coordinates converted by one F16C instruction
+#define SP_DISTANCE_HALF_LANES 8
+// The number of coordinates of a query converted to floats at once by the half precision
+// kernels, the distances of longer queries are summed over slabs of this many coordinates
+#define SP_DISTANCE_HALF_QUERY_SLAB 1024
+// The number of queries and rows of a tile of the matrix micro-kernel
+#define SP_DISTANCE_TILE_QUERIES 2
+#define SP_DISTANCE_TILE_ROWS 4
+// The size of a block of rows kept in the cache by the matrix kernel
+#define SP_DISTANCE_CACHE_BLOCK_BYTES (128 * 1024)
+
+/*
+ * The vector type of the kernels and its operations
+ * AVX - 4 doubles, SSE2 - 2 doubles, otherwise a scalar double
+ */
+#if defined(__AVX__)
+typedef __m256d SPDistanceVector;
+#define SP_DISTANCE_LANES 4
+
+static inline SPDistanceVector spDistanceZero() {
+	return _mm256_setzero_pd();
+}
+
+static inline SPDistanceVector spDistanceLoad(const double* address) {
+	return _mm256_loadu_pd(address);
+}
+
+static inline SPDistanceVector spDistanceSub(SPDistanceVector a, SPDistanceVector b) {
+	return _mm256_sub_pd(a, b);
+}
+
+static inline SPDistanceVector spDistanceAdd(SPDistanceVector a, SPDistanceVector b) {
+	return _mm256_add_pd(a, b);
+}
+
+// returns acc + a * b
+static inline SPDistanceVector spDistanceMulAdd(SPDistanceVector a, SPDistanceVector b,
+		SPDistanceVector acc) {
+#ifdef __FMA__
+	return _mm256_fmadd_pd(a, b, acc);
+#else
+	return _mm256_add_pd(acc, _mm256_mul_pd(a, b));
+#endif
+}
+
+// returns |a|, by clearing the sign bits
+static inline SPDistanceVector spDistanceAbs(SPDistanceVector a) {
+	return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+}
+
+static inline double spDistanceSum(SPDistanceVector a) {
+	__m128d half = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+#elif defined(__SSE2__)
+typedef __m128d SPDistanceVector;
+#define SP_DISTANCE_LANES 2
+
+static inline SPDistanceVector spDistanceZero() {
+	return _mm_setzero_pd();
+}
+
+static inline SPDistanceVector spDistanceLoad(const double* address) {
+	return _mm_loadu_pd(address);
+}
+
+static inline SPDistanceVector spDistanceSub(SPDistanceVector a, SPDistanceVector b) {
+	return _mm_sub_pd(a, b);
+}
+
+static inline SPDistanceVector spDistanceAdd(SPDistanceVector a, SPDistanceVector b) {
+	return _mm_add_pd(a, b);
+}
+
+// returns acc + a * b
+static inline SPDistanceVector spDistanceMulAdd(SPDistanceVector a, SPDistanceVector b,
+		SPDistanceVector acc) {
+	return _mm_add_pd(acc, _mm_mul_pd(a, b));
+}
+
+// returns |a|, by clearing the sign bits
+static inline SPDistanceVector spDistanceAbs(SPDistanceVector a) {
+	return _mm_andnot_pd(_mm_set1_pd(-0.0), a);
+}
+
+static inline double spDistanceSum(SPDistanceVector a) {
+	return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+}
+
+#else
+typedef double SPDistanceVector;
+#define SP_DISTANCE_LANES 1
+
+static inline SPDistanceVector spDistanceZero() {
+	return 0.0;
+}
+
+static inline SPDistanceVector spDistanceLoad(const double* address) {
+	return *address;
+}
+
+static inline SPDistanceVector spDistanceSub(SPDistanceVector a, SPDistanceVector b) {
+	return a - b;
+}
+
+static inline SPDistanceVector spDistanceAdd(SPDistanceVector a, SPDistanceVector b) {
+	return a + b;
+}
+
+// returns acc + a * b
+static inline SPDistanceVector spDistanceMulAdd(SPDistanceVector a, SPDistanceVector b,
+		SPDistanceVector acc) {
+	return acc + a * b;
+}
+
+static inline SPDistanceVector spDistanceAbs(SPDistanceVector a) {
+	return a < 0.0 ? -a : a;
+}
+
+static inline double spDistanceSum(SPDistanceVector a) {
+	return a;
+}
+#endif
+
+// the body of spDistanceL2Squared, inlined into the kernels of a fixed dimension
+static inline double spDistanceL2SquaredInline(const double* p, const double* q, int dim) {
+	SPDistanceVector acc0 = spDistanceZero(), acc1 = spDistanceZero(), diff0, diff1;
+	double sum, diff;
+	int i = 0;
+
+	// two independent accumulators hide the latency of the additions
+	for (; i + 2 * SP_DISTANCE_LANES <= dim; i += 2 * SP_DISTANCE_LANES) {
+		diff0 = spDistanceSub(spDistanceLoad(p + i), spDistanceLoad(q + i));
+		diff1 = spDistanceSub(spDistanceLoad(p + i + SP_DISTANCE_LANES),
+				spDistanceLoad(q + i + SP_DISTANCE_LANES));
+		acc0 = spDistanceMulAdd(diff0, diff0, acc0);
+		acc1 = spDistanceMulAdd(diff1, diff1, acc1);
+	}
+	sum = spDistanceSum(spDistanceAdd(acc0, acc1));
+	for (; i < dim; i++) {
+		diff = p[i] - q[i];
+		sum += diff * diff;
+	}
+	return sum;
+}
+
+double spDistanceL2Squared(const double* p, const double* q, int dim) {
+	assert(p != NULL && q != NULL && dim > 0);
+	return spDistanceL2SquaredInline(p, q, dim);
+}
+
+/*
+ * calculates the L2 squared distances of q to exactly SP_DISTANCE_BLOCK_SIZE rows,
+ * every vector of q is loaded once and kept in a register for all the rows.
+ * Each row is summed in the order of spDistanceL2Squared, so the results are equal.
+ */
+static inline void spDistanceL2SquaredFullBlock(const double* q, const double* const* rows,
+		int dim, double* out) {
+	SPDistanceVector acc00 = spDistanceZero(), acc01 = spDistanceZero();
+	SPDistanceVector acc10 = spDistanceZero(), acc11 = spDistanceZero();
+	SPDistanceVector acc20 = spDistanceZero(), acc21 = spDistanceZero();
+	SPDistanceVector acc30 = spDistanceZero(), acc31 = spDistanceZero();
+	SPDistanceVector query0, query1, diff;
+	const double* row0 = rows[0];
+	const double* row1 = rows[1];
+	const double* row2 = rows[2];
+	const double* row3 = rows[3];
+	double diff0, diff1, diff2, diff3;
+	int i = 0, j;
+
+	for (; i + 2 * SP_DISTANCE_LANES <= dim; i += 2 * SP_DISTANCE_LANES) {
+		query0 = spDistanceLoad(q + i);
+		query1 = spDistanceLoad(q + i + SP_DISTANCE_LANES);
+		diff = spDistanceSub(query0, spDistanceLoad(row0 + i));
+		acc00 = spDistanceMulAdd(diff, diff, acc00);
+		diff = spDistanceSub(query1, spDistanceLoad(row0 + i + SP_DISTANCE_LANES));
+		acc01 = spDistanceMulAdd(diff, diff, acc01);
+		diff = spDistanceSub(query0, spDistanceLoad(row1 + i));
+		acc10 = spDistanceMulAdd(diff, diff, acc10);
+		diff = spDistanceSub(query1, spDistanceLoad(row1 + i + SP_DISTANCE_LANES));
+		acc11 = spDistanceMulAdd(diff, diff, acc11);
+		diff = spDistanceSub(query0, spDistanceLoad(row2 + i));
+		acc20 = spDistanceMulAdd(diff, diff, acc20);
+		diff = spDistanceSub(query1, spDistanceLoad(row2 + i + SP_DISTANCE_LANES));
+		acc21 = spDistanceMulAdd(diff, diff, acc21);
+		diff = spDistanceSub(query0, spDistanceLoad(row3 + i));
+		acc30 = spDistanceMulAdd(diff, diff, acc30);
+		diff = spDistanceSub(query1, spDistanceLoad(row3 + i + SP_DISTANCE_LANES));
+		acc31 = spDistanceMulAdd(diff, diff, acc31);
+	}
+	out[0] = spDistanceSum(spDistanceAdd(acc00, acc01));
+	out[1] = spDistanceSum(spDistanceAdd(acc10, acc11));
+	out[2] = spDistanceSum(spDistanceAdd(acc20, acc21));
+	out[3] = spDistanceSum(spDistanceAdd(acc30, acc31));
+	for (j = i; j < dim; j++) {
+		diff0 = q[j] - row0[j];
+		diff1 = q[j] - row1[j];
+		diff2 = q[j] - row2[j];
+		diff3 = q[j] - row3[j];
+		out[0] += diff0 * diff0;
+		out[1] += diff1 * diff1;
+		out[2] += diff2 * diff2;
+		out[3] += diff3 * diff3;
+	}
+}
+
+// the body of spDistanceL2SquaredBlock
+static inline void spDistanceL2SquaredBlockInline(const double* q, const double* const* rows,
+		int count, int dim, double* out) {
+	int i;
+
+	if (count == SP_DISTANCE_BLOCK_SIZE) {
+		spDistanceL2SquaredFullBlock(q, rows, dim, out);
+		return;
+	}
+	for (i = 0; i < count; i++)
+		out[i] = spDistanceL2SquaredInline(q, rows[i], dim);
+}
+
+// the body of spDistanceL2SquaredStrided
+static inline void spDistanceL2SquaredStridedInline(const double* q, const double* rows, int n,
+		int dim, size_t stride, double* out) {
+	const double* block[SP_DISTANCE_BLOCK_SIZE];
+	int i, j, count;
+
+	for (i = 0; i < n; i += SP_DISTANCE_BLOCK_SIZE) {
+		count = n - i < SP_DISTANCE_BLOCK_SIZE ? n - i : SP_DISTANCE_BLOCK_SIZE;
+		for (j = 0; j < count; j++)
+			block[j] = rows + (size_t) (i + j) * stride;
+		// the beginning of the rows of the next block, the hardware prefetcher follows each row
+		for (j = 0; j < SP_DISTANCE_BLOCK_SIZE && i + count + j < n; j++)
+			spDistancePrefetch(rows + (size_t) (i + count + j) * stride);
+		spDistanceL2SquaredBlockInline(q, block, count, dim, out + i);
+	}
+}
+
+void spDistanceL2SquaredBlock(const double* q, const double* const* rows, int count,
+		int dim, double* out) {
+	assert(q != NULL && rows != NULL && out != NULL && dim > 0);
+	assert(count > 0 && count <= SP_DISTANCE_BLOCK_SIZE);
+	spDistanceL2SquaredBlockInline(q, rows, count, dim, out);
+}
+
+void spDistanceL2SquaredStrided(const double* q, const double* rows, int n, int dim,
+		size_t stride, double* out) {
+	assert(q != NULL && rows != NULL && out != NULL && dim > 0 && stride >= (size_t) dim);
+	spDistanceL2SquaredStridedInline(q, rows, n, dim, stride, out);
+}
+
+/*
+ * defines spDistanceL2SquaredBlock<DIM> and spDistanceL2SquaredStrided<DIM>, the kernels
+ * of the dimension DIM. The inlined bodies get a constant dimension, so the compiler
+ * unrolls the coordinate loops and removes their tails, and the arithmetic is the same.
+ */
+#define SP_DISTANCE_FIXED_KERNELS(DIM) \
+	static void spDistanceL2SquaredBlock##DIM(const double* q, const double* const* rows, \
+			int count, int dim, double* out) { \
+		assert(q != NULL && rows != NULL && out != NULL && dim == DIM); \
+		assert(count > 0 && count <= SP_DISTANCE_BLOCK_SIZE); \
+		(void) dim; \
+		spDistanceL2SquaredBlockInline(q, rows, count, DIM, out); \
+	} \
+	static void spDistanceL2SquaredStrided##DIM(const double* q, const double* rows, int n, \
+			int dim, size_t stride, double* out) { \
+		assert(q != NULL && rows != NULL && out != NULL && dim == DIM && stride >= DIM); \
+		(void) dim; \
+		spDistanceL2SquaredStridedInline(q, rows, n, DIM, stride, out); \
+	}
+
+SP_DISTANCE_FIXED_KERNELS(2)
+SP_DISTANCE_FIXED_KERNELS(3)
+SP_DISTANCE_FIXED_KERNELS(64)
+SP_DISTANCE_FIXED_KERNELS(128)
+SP_DISTANCE_FIXED_KERNELS(256)
+
+SPDistanceBlockKernel spDistanceL2SquaredBlockFor(int dim) {
+	switch (dim) {
+	case 2:
+		return spDistanceL2SquaredBlock2;
+	case 3:
+		return spDistanceL2SquaredBlock3;
+	case 64:
+		return spDistanceL2SquaredBlock64;
+	case 128:
+		return spDistanceL2SquaredBlock128;
+	case 256:
+		return spDistanceL2SquaredBlock256;
+	default:
+		return spDistanceL2SquaredBlock;
+	}
+}
+
+SPDistanceStridedKernel spDistanceL2SquaredStridedFor(int dim) {
+	switch (dim) {
+	case 2:
+		return spDistanceL2SquaredStrided2;
+	case 3:
+		return spDistanceL2SquaredStrided3;
+	case 64:
+		return spDistanceL2SquaredStrided64;
+	case 128:
+		return spDistanceL2SquaredStrided128;
+	case 256:
+		return spDistanceL2SquaredStrided256;
+	default:
+		return spDistanceL2SquaredStrided;
+	}
+}
+
+double spDistanceSquaredNorm(const double* p, int dim) {
+	SPDistanceVector acc0 = spDistanceZero(), acc1 = spDistanceZero(), v0, v1;
+	double sum;
+	int i = 0;
+
+	assert(p != NULL && dim > 0);
+
+	for (; i + 2 * SP_DISTANCE_LANES <= dim; i += 2 * SP_DISTANCE_LANES) {
+		v0 = spDistanceLoad(p + i);
+		v1 = spDistanceLoad(p + i + SP_DISTANCE_LANES);
+		acc0 = spDistanceMulAdd(v0, v0, acc0);
+		acc1 = spDistanceMulAdd(v1, v1, acc1);
+	}
+	sum = spDistanceSum(spDistanceAdd(acc0, acc1));
+	for (; i < dim; i++)
+		sum += p[i] * p[i];
+	return sum;
+}
+
+double spDistanceL1(const double* p, const double* q, int dim) {
+	SPDistanceVector acc0 = spDistanceZero(), acc1 = spDistanceZero();
+	double sum, diff;
+	int i = 0;
+
+	assert(p != NULL && q != NULL && dim > 0);
+
+	for (; i + 2 * SP_DISTANCE_LANES <= dim; i += 2 * SP_DISTANCE_LANES) {
+		acc0 = spDistanceAdd(acc0,
+				spDistanceAbs(spDistanceSub(spDistanceLoad(p + i), spDistanceLoad(q + i))));
+		acc1 = spDistanceAdd(acc1, spDistanceAbs(spDistanceSub(spDistanceLoad(p + i + SP_DISTANCE_LANES),
+				spDistanceLoad(q + i + SP_DISTANCE_LANES))));
+	}
+	sum = spDistanceSum(spDistanceAdd(acc0, acc1));
+	for (; i < dim; i++) {
+		diff = p[i] - q[i];
+		sum += diff < 0.0 ? -diff : diff;
+	}
+	return sum;
+}
+
+double spDistanceInnerProduct(const double* p, const double* q, int dim) {
+	SPDistanceVector acc0 = spDistanceZero(), acc1 = spDistanceZero();
+	double sum;
+	int i = 0;
+
+	assert(p != NULL && q != NULL && dim > 0);
+
+	for (; i + 2 * SP_DISTANCE_LANES <= dim; i += 2 * SP_DISTANCE_LANES) {
+		acc0 = spDistanceMulAdd(spDistanceLoad(p + i), spDistanceLoad(q + i), acc0);
+		acc1 = spDistanceMulAdd(spDistanceLoad(p + i + SP_DISTANCE_LANES),
+				spDistanceLoad(q + i + SP_DISTANCE_LANES), acc1);
+	}
+	sum = spDistanceSum(spDistanceAdd(acc0, acc1));
+	for (; i < dim; i++)
+		sum += p[i] * q[i];
+	return sum;
+}
+
+double spDistanceCosine(double innerProduct, double squaredNorm1, double squaredNorm2) {
+	double distance;
+
+	if (squaredNorm1 == 0.0 || squaredNorm2 == 0.0)
+		return 1.0;
+	distance = 1.0 - innerProduct / sqrt(squaredNorm1 * squaredNorm2);
+	// the rounding may take a distance slightly out of [0, 2]
+	return distance < 0.0 ? 0.0 : (distance > 2.0 ? 2.0 : distance);
+}
+
+// the number of set bits of word, a single POPCNT instruction when it is available
+static inline int spDistancePopCount(uint64_t word) {
+#ifdef __GNUC__
+	return __builtin_popcountll(word);
+#else
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int) ((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+int spDistanceHamming(const uint64_t* p, const uint64_t* q, int words) {
+	__m512i counts = _mm512_setzero_si512(), diff;
+	__mmask8 mask;
+	int i = 0;
+
+	assert(p != NULL && q != NULL && words > 0);
+
+	// 8 words per VPOPCNTQ, the last words (a whole 256 bit descriptor) with a masked load
+	for (; i + 8 <= words; i += 8) {
+		diff = _mm512_xor_si512(_mm512_loadu_si512(p + i), _mm512_loadu_si512(q + i));
+		counts = _mm512_add_epi64(counts, _mm512_popcnt_epi64(diff));
+	}
+	if (i < words) {
+		mask = (__mmask8) ((1u << (words - i)) - 1);
+		diff = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, p + i),
+				_mm512_maskz_loadu_epi64(mask, q + i));
+		counts = _mm512_add_epi64(counts, _mm512_popcnt_epi64(diff));
+	}
+	return (int) _mm512_reduce_add_epi64(counts);
+}
+
+#else
+int spDistanceHamming(const uint64_t* p, const uint64_t* q, int words) {
+	int count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+	int i = 0;
+
+	assert(p != NULL && q != NULL && words > 0);
+
+	// four independent counts, POPCNT has a latency of 3 cycles and a throughput of 1
+	for (; i + 4 <= words; i += 4) {
+		count0 += spDistancePopCount(p[i] ^ q[i]);
+		count1 += spDistancePopCount(p[i + 1] ^ q[i + 1]);
+		count2 += spDistancePopCount(p[i + 2] ^ q[i + 2]);
+		count3 += spDistancePopCount(p[i + 3] ^ q[i + 3]);
+	}
+	for (; i < words; i++)
+		count0 += spDistancePopCount(p[i] ^ q[i]);
+	return count0 + count1 + count2 + count3;
+}
+#endif
+
+// the dot product of p and q
+static inline double spDistanceDot(const double* p, const double* q, int dim) {
+	SPDistanceVector acc = spDistanceZero();
+	double sum;
+	int i = 0;
+
+	for (; i + SP_DISTANCE_LANES <= dim; i += SP_DISTANCE_LANES)
+		acc = spDistanceMulAdd(spDistanceLoad(p + i), spDistanceLoad(q + i), acc);
+	sum = spDistanceSum(acc);
+	for (; i < dim; i++)
+		sum += p[i] * q[i];
+	return sum;
+}
+
+/*
+ * the micro-kernel, the dot products of a tile of SP_DISTANCE_TILE_QUERIES queries
+ * and SP_DISTANCE_TILE_ROWS rows, all the 8 sums are kept in registers and every
+ * loaded vector is used by 2 or 4 multiply-adds
+ */
+static inline void spDistanceDotTile(const double* q0, const double* q1, const double* const* rows,
+		int dim, double dots[SP_DISTANCE_TILE_QUERIES][SP_DISTANCE_TILE_ROWS]) {
+	SPDistanceVector acc00 = spDistanceZero(), acc01 = spDistanceZero();
+	SPDistanceVector acc02 = spDistanceZero(), acc03 = spDistanceZero();
+	SPDistanceVector acc10 = spDistanceZero(), acc11 = spDistanceZero();
+	SPDistanceVector acc12 = spDistanceZero(), acc13 = spDistanceZero();
+	SPDistanceVector query0, query1, row;
+	const double* row0 = rows[0];
+	const double* row1 = rows[1];
+	const double* row2 = rows[2];
+	const double* row3 = rows[3];
+	int i = 0, j;
+
+	for (; i + SP_DISTANCE_LANES <= dim; i += SP_DISTANCE_LANES) {
+		query0 = spDistanceLoad(q0 + i);
+		query1 = spDistanceLoad(q1 + i);
+		row = spDistanceLoad(row0 + i);
+		acc00 = spDistanceMulAdd(query0, row, acc00);
+		acc10 = spDistanceMulAdd(query1, row, acc10);
+		row = spDistanceLoad(row1 + i);
+		acc01 = spDistanceMulAdd(query0, row, acc01);
+		acc11 = spDistanceMulAdd(query1, row, acc11);
+		row = spDistanceLoad(row2 + i);
+		acc02 = spDistanceMulAdd(query0, row, acc02);
+		acc12 = spDistanceMulAdd(query1, row, acc12);
+		row = spDistanceLoad(row3 + i);
+		acc03 = spDistanceMulAdd(query0, row, acc03);
+		acc13 = spDistanceMulAdd(query1, row, acc13);
+	}
+	dots[0][0] = spDistanceSum(acc00);
+	dots[0][1] = spDistanceSum(acc01);
+	dots[0][2] = spDistanceSum(acc02);
+	dots[0][3] = spDistanceSum(acc03);
+	dots[1][0] = spDistanceSum(acc10);
+	dots[1][1] = spDistanceSum(acc11);
+	dots[1][2] = spDistanceSum(acc12);
+	dots[1][3] = spDistanceSum(acc13);
+	for (j = i; j < dim; j++) {
+		dots[0][0] += q0[j] * row0[j];
+		dots[0][1] += q0[j] * row1[j];
+		dots[0][2] += q0[j] * row2[j];
+		dots[0][3] += q0[j] * row3[j];
+		dots[1][0] += q1[j] * row0[j];
+		dots[1][1] += q1[j] * row1[j];
+		dots[1][2] += q1[j] * row2[j];
+		dots[1][3] += q1[j] * row3[j];
+	}
+}
+
+// the distance from its norms and dot product, clamped to 0
+static inline double spDistanceFromDot(double queryNorm, double norm, double dot) {
+	double distance = queryNorm + norm - 2.0 * dot;
+	return distance > 0.0 ? distance : 0.0;
+}
+
+void spDistanceL2SquaredMatrix(const double* queries, const double* queryNorms, int m,
+		size_t queriesStride, const double* rows, const double* norms, int n, size_t stride,
+		int dim, double* out, size_t outStride) {
+	double dots[SP_DISTANCE_TILE_QUERIES][SP_DISTANCE_TILE_ROWS];
+	const double* tile[SP_DISTANCE_TILE_ROWS];
+	const double* q0;
+	const double* q1;
+	int blockRows, blockBegin, blockEnd, i, j, t;
+
+	assert(queries != NULL && queryNorms != NULL && rows != NULL && norms != NULL && out != NULL);
+	assert(dim > 0 && queriesStride >= (size_t) dim && stride >= (size_t) dim && outStride >= (size_t) n);
+
+	// the number of rows of a cache block, a multiple of the tile
+	blockRows = (int) (SP_DISTANCE_CACHE_BLOCK_BYTES / (sizeof(double) * stride));
+	blockRows = blockRows < SP_DISTANCE_TILE_ROWS ? SP_DISTANCE_TILE_ROWS
+			: blockRows / SP_DISTANCE_TILE_ROWS * SP_DISTANCE_TILE_ROWS;
+
+	for (blockBegin = 0; blockBegin < n; blockBegin += blockRows) {
+		blockEnd = blockBegin + blockRows < n ? blockBegin + blockRows : n;
+		for (i = 0; i < m; i += SP_DISTANCE_TILE_QUERIES) {
+			q0 = queries + (size_t) i * queriesStride;
+			// a single last query is paired with itself
+			q1 = i + 1 < m ? q0 + queriesStride : q0;
+			for (j = blockBegin; j + SP_DISTANCE_TILE_ROWS <= blockEnd; j += SP_DISTANCE_TILE_ROWS) {
+				for (t = 0; t < SP_DISTANCE_TILE_ROWS; t++)
+					tile[t] = rows + (size_t) (j + t) * stride;
+				spDistanceDotTile(q0, q1, tile, dim, dots);
+				for (t = 0; t < SP_DISTANCE_TILE_ROWS; t++) {
+					out[(size_t) i * outStride + (size_t) (j + t)] =
+							spDistanceFromDot(queryNorms[i], norms[j + t], dots[0][t]);
+					if (i + 1 < m)
+						out[(size_t) (i + 1) * outStride + (size_t) (j + t)] =
+								spDistanceFromDot(queryNorms[i + 1], norms[j + t], dots[1][t]);
+				}
+			}
+			for (; j < blockEnd; j++) {
+				out[(size_t) i * outStride + (size_t) j] = spDistanceFromDot(queryNorms[i],
+						norms[j], spDistanceDot(q0, rows + (size_t) j * stride, dim));
+				if (i + 1 < m)
+					out[(size_t) (i + 1) * outStride + (size_t) j] = spDistanceFromDot(queryNorms[i + 1],
+							norms[j], spDistanceDot(q1, rows + (size_t) j * stride, dim));
+			}
+		}
+	}
+}
+
+double spDistanceL2SquaredMatrixError(double queryNorm, double norm, int dim) {
+	// the rounding of the dot product is bounded by dim * eps * ||q|| * ||p||, which is at
+	// most dim * eps * (||q||^2 + ||p||^2) / 2, the rounding of the sum adds a few more eps
+	return (dim + 4) * DBL_EPSILON * (queryNorm + norm);
+}
+
+float spDistanceHalfToFloat(uint16_t half) {
+	uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x3FF;
+	uint32_t bits;
+	float value;
+
+	if (exponent == 0) { // zero or subnormal, mantissa * 2^-24
+		value = (float) mantissa * (1.0f / 16777216.0f);
+		return sign != 0 ? -value : value;
+	}
+	if (exponent == 0x1F) // infinity or NaN
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+uint16_t spDistanceFloatToHalf(float value) {
+	uint32_t bits, sign, mantissa, half, rest, halfway;
+	int exponent, shift;
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (bits >> 16) & 0x8000;
+	mantissa = bits & 0x7FFFFF;
+	if (((bits >> 23) & 0xFF) == 0xFF) // infinity or NaN, which stays a quiet NaN
+		return (uint16_t) (sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+
+	exponent = (int) ((bits >> 23) & 0xFF) - 127 + 15;
+	if (exponent >= 0x1F) // too large, infinity
+		return (uint16_t) (sign | 0x7C00);
+	if (exponent <= 0) { // a subnormal half, or zero below half of the smallest one
+		if (exponent < -10)
+			return (uint16_t) sign;
+		mantissa |= 0x800000;
+		shift = 14 - exponent;
+		half = mantissa >> shift;
+		rest = mantissa & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+	} else {
+		half = ((uint32_t) exponent << 10) | (mantissa >> 13);
+		rest = mantissa & 0x1FFF;
+		halfway = 0x1000;
+	}
+	// rounds to nearest even, a carry into the exponent gives the next power of 2 or infinity
+	if (rest > halfway || (rest == halfway && (half & 1) != 0))
+		half++;
+	return (uint16_t) (sign | half);
+}
+
+// true if the half precision kernels may use F16C on this processor
+static inline bool spDistanceHasF16C() {
+#if defined(SP_DISTANCE_F16C_DISPATCH)
+	return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#elif defined(SP_DISTANCE_F16C)
+	return true;
+#else
+	return false;
+#endif
+}
+
+#ifdef SP_DISTANCE_F16C
+// rounds n doubles to halves, 8 at a time by one VCVTPS2PH, and returns the number rounded
+SP_DISTANCE_F16C_TARGET
+static int spDistanceToHalfF16C(const double* source, uint16_t* destination, int n) {
+	__m256 values;
+	int i = 0;
+
+	for (; i + SP_DISTANCE_HALF_LANES <= n; i += SP_DISTANCE_HALF_LANES) {
+		values = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_loadu_pd(source + i))),
+				_mm256_cvtpd_ps(_mm256_loadu_pd(source + i + 4)), 1);
+		_mm_storeu_si128((__m128i*) (destination + i),
+				_mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+	}
+	return i;
+}
+#endif
+
+void spDistanceToHalf(const double* source, uint16_t* destination, int n) {
+	int i = 0;
+
+	assert(n >= 0 && (n == 0 || (source != NULL && destination != NULL)));
+
+#ifdef SP_DISTANCE_F16C
+	if (spDistanceHasF16C())
+		i = spDistanceToHalfF16C(source, destination, n);
+#endif
+	for (; i < n; i++)
+		destination[i] = spDistanceFloatToHalf((float) source[i]);
+}
+
+#ifdef SP_DISTANCE_F16C
+// 8 half precision coordinates converted to floats by one VCVTPH2PS
+SP_DISTANCE_F16C_TARGET
+static inline __m256 spDistanceLoadHalfLanes(const uint16_t* row) {
+	return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) row));
+}
+
+// returns acc + diff * diff
+SP_DISTANCE_F16C_TARGET
+static inline __m256 spDistanceHalfSquareAdd(__m256 diff, __m256 acc) {
+#ifdef __FMA__
+	return _mm256_fmadd_ps(diff, diff, acc);
+#else
+	return _mm256_add_ps(acc, _mm256_mul_ps(diff, diff));
+#endif
+}
+
+SP_DISTANCE_F16C_TARGET
+static inline float spDistanceHalfSum(__m256 a) {
+	__m128 half = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+	return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+}
+
+/*
+ * adds the squared distances of the float query q to count <= SP_DISTANCE_BLOCK_SIZE
+ * half precision rows to sums, 8 coordinates of every row are converted by one F16C
+ * instruction
+ */
+SP_DISTANCE_F16C_TARGET
+static inline void spDistanceL2SquaredHalfBlockF16C(const float* q, const uint16_t* const* rows,
+		int count, int dim, float* sums) {
+	__m256 acc[SP_DISTANCE_BLOCK_SIZE], query, delta;
+	float diff;
+	int i = 0, j;
+
+	for (j = 0; j < count; j++)
+		acc[j] = _mm256_setzero_ps();
+	for (; i + SP_DISTANCE_HALF_LANES <= dim; i += SP_DISTANCE_HALF_LANES) {
+		query = _mm256_loadu_ps(q + i);
+		for (j = 0; j < count; j++) {
+			delta = _mm256_sub_ps(query, spDistanceLoadHalfLanes(rows[j] + i));
+			acc[j] = spDistanceHalfSquareAdd(delta, acc[j]);
+		}
+	}
+	for (j = 0; j < count; j++)
+		sums[j] += spDistanceHalfSum(acc[j]);
+	for (; i < dim; i++) {
+		for (j = 0; j < count; j++) {
+			diff = q[i] - spDistanceHalfToFloat(rows[j][i]);
+			sums[j] += diff * diff;
+		}
+	}
+}
+#endif
+
+/*
+ * adds the squared distances of the float query q to count <= SP_DISTANCE_BLOCK_SIZE
+ * half precision rows to sums, without F16C
+ */
+static inline void spDistanceL2SquaredHalfBlockScalar(const float* q, const uint16_t* const* rows,
+		int count, int dim, float* sums) {
+	float diff;
+	int i, j;
+
+	for (i = 0; i < dim; i++) {
+		for (j = 0; j < count; j++) {
+			diff = q[i] - spDistanceHalfToFloat(rows[j][i]);
+			sums[j] += diff * diff;
+		}
+	}
+}
+
+// a kernel adding the squared distances of a float query to a block of half precision rows
+typedef void (*SPDistanceHalfBlockKernel)(const float* q, const uint16_t* const* rows, int count,
+		int dim, float* sums);
+
+/*
+ * adds the squared distances of the float query q to dim coordinates of the n rows to out,
+ * a block of SP_DISTANCE_BLOCK_SIZE rows at a time by the constant kernel, which is inlined
+ * into the callers below
+ */
+static inline void spDistanceL2SquaredHalfRows(const float* q, const uint16_t* rows, int n,
+		int dim, size_t stride, bool add, double* out, SPDistanceHalfBlockKernel kernel) {
+	float sums[SP_DISTANCE_BLOCK_SIZE];
+	const uint16_t* block[SP_DISTANCE_BLOCK_SIZE];
+	int i, j, count;
+
+	for (i = 0; i < n; i += SP_DISTANCE_BLOCK_SIZE) {
+		count = n - i < SP_DISTANCE_BLOCK_SIZE ? n - i : SP_DISTANCE_BLOCK_SIZE;
+		for (j = 0; j < count; j++) {
+			block[j] = rows + (size_t) (i + j) * stride;
+			sums[j] = 0.0f;
+		}
+		for (j = 0; j < SP_DISTANCE_BLOCK_SIZE && i + count + j < n; j++)
+			spDistancePrefetch(rows + (size_t) (i + count + j) * stride);
+		kernel(q, block, count, dim, sums);
+		for (j = 0; j < count; j++)
+			out[i + j] = add ? out[i + j] + sums[j] : sums[j];
+	}
+}
+
+#ifdef SP_DISTANCE_F16C
+SP_DISTANCE_F16C_TARGET
+static void spDistanceL2SquaredHalfRowsF16C(const float* q, const uint16_t* rows, int n,
+		int dim, size_t stride, bool add, double* out) {
+	spDistanceL2SquaredHalfRows(q, rows, n, dim, stride, add, out, spDistanceL2SquaredHalfBlockF16C);
+}
+#endif
+
+static void spDistanceL2SquaredHalfRowsScalar(const float* q, const uint16_t* rows, int n,
+		int dim, size_t stride, bool add, double* out) {
+	spDistanceL2SquaredHalfRows(q, rows, n, dim, stride, add, out, spDistanceL2SquaredHalfBlockScalar);
+}
+
+void spDistanceL2SquaredHalfStrided(const double* q, const uint16_t* rows, int n, int dim,
+		size_t stride, double* out) {
+	float query[SP_DISTANCE_HALF_QUERY_SLAB];
+#ifdef SP_DISTANCE_F16C
+	bool f16c = spDistanceHasF16C();
+#endif
+	int first, width, axis;
+
+	assert(q != NULL && rows != NULL && out != NULL && dim > 0 && stride >= (size_t) dim);
+
+	// the query is rounded to floats once per slab instead of once per row
+	for (first = 0; first < dim; first += SP_DISTANCE_HALF_QUERY_SLAB) {
+		width = dim - first < SP_DISTANCE_HALF_QUERY_SLAB ? dim - first : SP_DISTANCE_HALF_QUERY_SLAB;
+		for (axis = 0; axis < width; axis++)
+			query[axis] = (float) q[first + axis];
+#ifdef SP_DISTANCE_F16C
+		if (f16c) {
+			spDistanceL2SquaredHalfRowsF16C(query, rows + first, n, width, stride, first > 0, out);
+			continue;
+		}
+#endif
+		spDistanceL2SquaredHalfRowsScalar(query, rows + first, n, width, stride, first > 0, out);
+	}
+}
@@ -0,0 +1,290 @@
+#ifndef SPDISTANCE_H_
+#define SPDISTANCE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * SPDistance Summary
+ * Distance kernels over raw coordinates arrays, shared by SPPoint and
+ * SPPointStore. The kernels are vectorised with AVX when the library is
+ * compiled with it (e.g. -march=native), with SSE2 otherwise on x86-64, and
+ * fall back to scalar code on other targets.
+ *
+ * The vectorised kernels sum the coordinates in a different order than the
+ * scalar loop of spPointL2SquaredDistance, so their results may differ from
+ * it in the last bits.
+ *
+ * The following functions are supported:
+ *
+ * spDistanceL2Squared			- The L2 squared distance between two arrays
+ * spDistanceL2SquaredBlock		- The L2 squared distances of a query to a block of rows
+ * spDistanceL2SquaredStrided	- The L2 squared distances of a query to the rows of a matrix
+ * spDistanceL2SquaredBlockFor	- The block kernel specialised for a given dimension
+ * spDistanceL2SquaredStridedFor	- The matrix kernel specialised for a given dimension
+ * spDistanceSquaredNorm		- The squared L2 norm of an array
+ * spDistanceL1					- The L1 distance between two arrays
+ * spDistanceInnerProduct		- The inner product of two arrays
+ * spDistanceCosine				- The cosine distance of two arrays from their inner product and norms
+ * spDistanceHamming			- The Hamming distance between two packed binary descriptors
+ * spDistanceHalfToFloat		- Converts a half precision (fp16) value to a float
+ * spDistanceFloatToHalf		- Converts a float to the nearest half precision (fp16) value
+ * spDistanceToHalf				- Converts an array of doubles to half precision values
+ * spDistanceL2SquaredHalfStrided	- The L2 squared distances of a query to the rows of a
+ * 								  half precision matrix
+ * spDistanceL2SquaredMatrix	- The L2 squared distances between the rows of two matrices
+ * spDistancePrefetch			- Hints the processor to load an address to the cache
+ */
+
+/** The maximal number of rows handled by one call of spDistanceL2SquaredBlock **/
+#define SP_DISTANCE_BLOCK_SIZE 4
+
+/**
+ * Calculates the L2 squared distance between p and q
+ *
+ * @param p - The first array
+ * @param q - The second array
+ * @param dim - The number of coordinates of p and q
+ * @assert p != NULL AND q != NULL AND dim > 0
+ * @return
+ * The L2 squared distance between p and q
+ */
+double spDistanceL2Squared(const double* p, const double* q, int dim);
+
+/**
+ * Calculates the L2 squared distances of the query q to count rows, such that
+ * out[i] is the distance between q and rows[i].
+ * Every coordinate of q is loaded once for all the rows, and the distances are
+ * equal to those of spDistanceL2Squared.
+ *
+ * @param q - The query array
+ * @param rows - The rows, count arrays of dim coordinates
+ * @param count - The number of rows
+ * @param dim - The number of coordinates of q and of every row
+ * @param out - An array of at least count distances
+ * @assert q != NULL AND rows != NULL AND out != NULL AND dim > 0
+ * 		   AND 0 < count <= SP_DISTANCE_BLOCK_SIZE
+ */
+void spDistanceL2SquaredBlock(const double* q, const double* const* rows, int count,
+		int dim, double* out);
+
+/**
+ * Calculates the L2 squared distances of the query q to the n rows of a matrix,
+ * such that out[i] is the distance between q and the row rows + i * stride.
+ * The upcoming rows are prefetched while the current ones are processed.
+ *
+ * @param q - The query array
+ * @param rows - The matrix, n rows of dim coordinates, stride doubles apart
+ * @param n - The number of rows
+ * @param dim - The number of coordinates of q and of every row
+ * @param stride - The distance between the beginnings of two rows, in doubles
+ * @param out - An array of at least n distances
+ * @assert q != NULL AND rows != NULL AND out != NULL AND dim > 0 AND stride >= dim
+ */
+void spDistanceL2SquaredStrided(const double* q, const double* rows, int n, int dim,
+		size_t stride, double* out);
+
+/** Type of spDistanceL2SquaredBlock and of its specialisations **/
+typedef void (*SPDistanceBlockKernel)(const double* q, const double* const* rows, int count,
+		int dim, double* out);
+
+/** Type of spDistanceL2SquaredStrided and of its specialisations **/
+typedef void (*SPDistanceStridedKernel)(const double* q, const double* rows, int n, int dim,
+		size_t stride, double* out);
+
+/**
+ * Selects the kernel of spDistanceL2SquaredBlock for rows of dim coordinates.
+ * The common dimensions (2, 3, 64, 128 and 256) have kernels compiled for their
+ * dimension, whose loops are unrolled and have no tails, other dimensions get
+ * spDistanceL2SquaredBlock. The distances are equal to those of spDistanceL2SquaredBlock.
+ * The kernel must only be called with the given dim, so it is meant to be
+ * selected once for a collection of points of the same dimension.
+ *
+ * @param dim - The number of coordinates of the query and of the rows
+ * @return
+ * The kernel for the dimension dim
+ */
+SPDistanceBlockKernel spDistanceL2SquaredBlockFor(int dim);
+
+/**
+ * Selects the kernel of spDistanceL2SquaredStrided for rows of dim coordinates,
+ * the specialised dimensions are those of spDistanceL2SquaredBlockFor.
+ * The distances are equal to those of spDistanceL2SquaredStrided.
+ *
+ * @param dim - The number of coordinates of the query and of the rows
+ * @return
+ * The kernel for the dimension dim
+ */
+SPDistanceStridedKernel spDistanceL2SquaredStridedFor(int dim);
+
+/**
+ * Calculates the squared L2 norm of p, p_0^2 + ... + p_{dim-1}^2
+ *
+ * @param p - The array
+ * @param dim - The number of coordinates of p
+ * @assert p != NULL AND dim > 0
+ * @return
+ * The squared L2 norm of p
+ */
+double spDistanceSquaredNorm(const double* p, int dim);
+
+/**
+ * Calculates the L1 distance between p and q, |p_0 - q_0| + ... + |p_{dim-1} - q_{dim-1}|
+ *
+ * @param p - The first array
+ * @param q - The second array
+ * @param dim - The number of coordinates of p and q
+ * @assert p != NULL AND q != NULL AND dim > 0
+ * @return
+ * The L1 distance between p and q
+ */
+double spDistanceL1(const double* p, const double* q, int dim);
+
+/**
+ * Calculates the inner product of p and q, p_0 * q_0 + ... + p_{dim-1} * q_{dim-1}
+ *
+ * @param p - The first array
+ * @param q - The second array
+ * @param dim - The number of coordinates of p and q
+ * @assert p != NULL AND q != NULL AND dim > 0
+ * @return
+ * The inner product of p and q
+ */
+double spDistanceInnerProduct(const double* p, const double* q, int dim);
+
+/**
+ * Calculates the cosine distance 1 - p.q / (||p|| * ||q||) of two arrays, from their
+ * inner product and squared norms, so cached norms are not recomputed.
+ *
+ * @param innerProduct - The inner product of the arrays
+ * @param squaredNorm1 - The squared L2 norm of the first array
+ * @param squaredNorm2 - The squared L2 norm of the second array
+ * @return
+ * The cosine distance, clamped to [0, 2], or 1 if one of the norms is 0
+ */
+double spDistanceCosine(double innerProduct, double squaredNorm1, double squaredNorm2);
+
+/**
+ * Calculates the Hamming distance between two binary descriptors packed into
+ * 64 bit words, the number of bits which differ. With AVX-512 VPOPCNTDQ
+ * (e.g. -march=native on Ice Lake or Zen 4) 8 words are counted by one instruction,
+ * otherwise every word is counted by a single POPCNT instruction when the library
+ * is compiled with it (e.g. -mpopcnt or -march=native).
+ *
+ * @param p - The words of the first descriptor
+ * @param q - The words of the second descriptor
+ * @param words - The number of words of p and q
+ * @assert p != NULL AND q != NULL AND words > 0
+ * @return
+ * The Hamming distance between p and q
+ */
+int spDistanceHamming(const uint64_t* p, const uint64_t* q, int words);
+
+/**
+ * Calculates the L2 squared distances between the m rows of the matrix queries
+ * and the n rows of the matrix rows, such that out[i * outStride + j] is the
+ * distance between the i-th query and the j-th row.
+ *
+ * The distances are computed as ||q||^2 + ||p||^2 - 2 q.p from the given squared
+ * norms, with a register blocked dot product micro-kernel over tiles of queries
+ * and rows, and the rows split into blocks which stay in the cache while all the
+ * queries are processed against them. The decomposition loses precision when
+ * the distance is much smaller than the norms, the error of a distance is at most
+ * spDistanceL2SquaredMatrixError of the norms, and negative results are clamped to 0.
+ *
+ * @param queries - The queries matrix, m rows of dim coordinates, queriesStride doubles apart
+ * @param queryNorms - The squared norms of the m queries
+ * @param m - The number of queries
+ * @param queriesStride - The distance between the beginnings of two queries, in doubles
+ * @param rows - The rows matrix, n rows of dim coordinates, stride doubles apart
+ * @param norms - The squared norms of the n rows
+ * @param n - The number of rows
+ * @param stride - The distance between the beginnings of two rows, in doubles
+ * @param dim - The number of coordinates of every query and row
+ * @param out - The distances matrix, m rows of at least n distances, outStride doubles apart
+ * @param outStride - The distance between the beginnings of two rows of out, in doubles
+ * @assert all arrays != NULL AND dim > 0 AND queriesStride >= dim AND stride >= dim
+ * 		   AND outStride >= n
+ */
+void spDistanceL2SquaredMatrix(const double* queries, const double* queryNorms, int m,
+		size_t queriesStride, const double* rows, const double* norms, int n, size_t stride,
+		int dim, double* out, size_t outStride);
+
+/**
+ * A bound on the absolute error of a distance computed by spDistanceL2SquaredMatrix
+ *
+ * @param queryNorm - The squared norm of the query
+ * @param norm - The squared norm of the row
+ * @param dim - The number of coordinates
+ * @return
+ * The maximal difference between the computed and the exact distance
+ */
+double spDistanceL2SquaredMatrixError(double queryNorm, double norm, int dim);
+
+/**
+ * Converts a half precision (IEEE 754 binary16) value, given by its bits, to a float.
+ * The conversion is exact.
+ *
+ * @param half - The bits of the half precision value
+ * @return
+ * The value as a float
+ */
+float spDistanceHalfToFloat(uint16_t half);
+
+/**
+ * Converts a float to the nearest half precision (IEEE 754 binary16) value, ties to
+ * even, as the F16C instruction VCVTPS2PH. Values beyond the largest half (65504)
+ * become infinities, and values below half of the smallest subnormal half become zeros.
+ *
+ * @param value - The float to convert
+ * @return
+ * The bits of the half precision value
+ */
+uint16_t spDistanceFloatToHalf(float value);
+
+/**
+ * Converts n doubles to half precision values, every double is rounded to a float
+ * and then by spDistanceFloatToHalf. With F16C (at compile time, or detected at run
+ * time as in spDistanceL2SquaredHalfStrided) 8 values are converted at once.
+ *
+ * @param source - The doubles to convert
+ * @param destination - An array of at least n half precision values
+ * @param n - The number of values
+ * @assert n >= 0 AND (n == 0 OR (source != NULL AND destination != NULL))
+ */
+void spDistanceToHalf(const double* source, uint16_t* destination, int n);
+
+/**
+ * Calculates the L2 squared distances of the query q to the n rows of a half
+ * precision matrix, such that out[i] is the distance between q and the row
+ * rows + i * stride. The coordinates of q are rounded to floats once per call, the
+ * rows are converted to floats in registers, and the distances are summed in single
+ * precision (over slabs of 1024 coordinates, which are then added in double precision).
+ * The rows are converted by F16C when the library is compiled with it (e.g. -mf16c
+ * or -march=native), or otherwise, with GCC or Clang on x86, when the processor
+ * supports it at run time.
+ *
+ * @param q - The query array
+ * @param rows - The matrix, n rows of dim half precision coordinates, stride values apart
+ * @param n - The number of rows
+ * @param dim - The number of coordinates of q and of every row
+ * @param stride - The distance between the beginnings of two rows, in half precision values
+ * @param out - An array of at least n distances
+ * @assert q != NULL AND rows != NULL AND out != NULL AND dim > 0 AND stride >= dim
+ */
+void spDistanceL2SquaredHalfStrided(const double* q, const uint16_t* rows, int n, int dim,
+		size_t stride, double* out);
+
+/**
+ * Hints the processor to load the cache line of address for reading,
+ * does nothing on compilers without a prefetch builtin.
+ */
+static inline void spDistancePrefetch(const void* address) {
+#ifdef __GNUC__
+	__builtin_prefetch(address, 0, 3);
+#else
+	(void) address;
+#endif
+}
+
+#endif /* SPDISTANCE_H_ */
@@ -0,0 +1,744 @@
+#include "SPKNNSearch.h"
+#include "SPBPriorityQueueInternal.h"
+#include "SPPointInternal.h"
+#include "SPPointStoreInternal.h"
+#include "SPBinaryPointInternal.h"
+#include "SPDistance.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+
+// The number of points whose distances are computed at once by the single query searches,
+// and which are pruned by their norms together
+#define SP_KNN_CHUNK_SIZE 256
+// The minimal dimension for which points are pruned by their norms before computing distances
+#define SP_KNN_PRUNE_MIN_DIM 16
+// The number of queries whose distances are computed at once by the batch search
+#define SP_KNN_QUERY_BLOCK_SIZE 16
+// The maximal number of neighbours which the single query searches keep in locals
+// instead of the result queue
+#define SP_KNN_NEAREST_MAX_K 2
+
+/*
+ * the nearest two points found so far by a search of at most SP_KNN_NEAREST_MAX_K
+ * neighbours, ordered as in SPBPQueue by their distances and then by their indices.
+ * A missing neighbour has an infinite distance and the index INT_MAX.
+ */
+typedef struct sp_knn_nearest_t {
+	double firstDistance;
+	int firstIndex;
+	double secondDistance;
+	int secondIndex;
+} SPKNNNearest;
+
+/*
+ * offers a candidate neighbour to the result queue, a candidate farther than the bound
+ * cannot enter the full queue and is skipped by the caller without touching the queue
+ * @result - the result queue
+ * @candidate - an element used to pass the candidate to the queue
+ * @index - the index of the candidate point
+ * @distance - the distance of the candidate from the query
+ * @bound - the maximal value of the queue once it is full, DBL_MAX before, updated
+ *
+ * @returns
+ * SP_KNN_OUT_OF_MEMORY if the queue failed to allocate the element, SP_KNN_SUCCESS otherwise
+ */
+SP_KNN_MSG spKNNOffer(SPBPQueue result, SPListElement candidate, int index, double distance,
+		double* bound) {
+	spListElementSetIndex(candidate, index);
+	spListElementSetValue(candidate, distance);
+	if (spBPQueueEnqueue(result, candidate) == SP_BPQUEUE_OUT_OF_MEMORY)
+		return SP_KNN_OUT_OF_MEMORY;
+	*bound = spBPQueueThreshold(result);
+	return SP_KNN_SUCCESS;
+}
+
+/*
+ * computes the range of squared norms of the points which may be within bound from the
+ * query, by the lower bound (||q|| - ||p||)^2 <= ||q - p||^2. The range is widened by
+ * the rounding errors of the lengths and of the distance kernel, so a point outside of
+ * it could never have entered the queue.
+ * @queryLength - the L2 norm of the query
+ * @dim - the dimension of the points
+ * @bound - the distance a point must not exceed to enter the queue
+ * @low, @high - receive the range of the squared norms
+ */
+static void spKNNNormRange(double queryLength, int dim, double bound, double* low,
+		double* high) {
+	double margin = (dim + 8) * DBL_EPSILON;
+	double radius = sqrt(bound) * (1.0 + margin) + margin * queryLength;
+	double lowLength = queryLength - radius;
+	double highLength = queryLength + radius;
+	*low = lowLength > 0.0 ? lowLength * lowLength * (1.0 - margin) : -1.0;
+	*high = highLength * highLength * (1.0 + margin);
+}
+
+/*
+ * finds the points of a chunk which are not pruned by their norms, when at least half
+ * of the chunk is pruned (otherwise computing the distances of the whole chunk at once
+ * is faster than gathering the remaining rows)
+ * @norms - the squared norms of the points
+ * @count - the number of points
+ * @queryLength - the L2 norm of the query
+ * @dim - the dimension of the points
+ * @bound - see spKNNOffer
+ * @positions - receives the positions of the remaining points in the chunk
+ *
+ * @returns
+ * the number of remaining points, or count if the whole chunk should be scanned
+ */
+int spKNNFilter(const double* norms, int count, double queryLength, int dim, double bound,
+		int* positions) {
+	double low, high;
+	int j, m = 0;
+
+	if (dim < SP_KNN_PRUNE_MIN_DIM || bound >= DBL_MAX)
+		return count;
+	spKNNNormRange(queryLength, dim, bound, &low, &high);
+	for (j = 0; j < count; j++)
+		m += norms[j] >= low && norms[j] <= high;
+	if (m > count / 2)
+		return count;
+	for (j = 0, m = 0; j < count; j++) {
+		positions[m] = j;
+		m += norms[j] >= low && norms[j] <= high;
+	}
+	return m;
+}
+
+/*
+ * computes the distances of the points at the given positions of a chunk from the query,
+ * in blocks of SP_DISTANCE_BLOCK_SIZE rows
+ * @query - the coordinates of the query
+ * @dim - the dimension of the points
+ * @kernel - the block kernel of the dimension, see spDistanceL2SquaredBlockFor
+ * @rows - the coordinates of the points of the chunk
+ * @positions - the positions of the points in the chunk
+ * @m - the number of points
+ * @distances - receives the distance of the point at positions[t] at distances[t]
+ */
+static void spKNNSelectedDistances(const double* query, int dim, SPDistanceBlockKernel kernel,
+		const double* const* rows, const int* positions, int m, double* distances) {
+	const double* block[SP_DISTANCE_BLOCK_SIZE];
+	int j, t, size;
+
+	for (j = 0; j < m; j += SP_DISTANCE_BLOCK_SIZE) {
+		size = m - j < SP_DISTANCE_BLOCK_SIZE ? m - j : SP_DISTANCE_BLOCK_SIZE;
+		for (t = 0; t < size; t++)
+			block[t] = rows[positions[j + t]];
+		kernel(query, block, size, dim, distances + j);
+	}
+}
+
+/*
+ * offers the points at the given positions of a chunk to the result queue
+ * @query - the coordinates of the query
+ * @dim - the dimension of the points
+ * @kernel - the block kernel of the dimension, see spDistanceL2SquaredBlockFor
+ * @rows - the coordinates of the points of the chunk
+ * @indices - the indices of the points of the chunk
+ * @positions - the positions of the offered points in the chunk
+ * @m - the number of offered points, at most SP_KNN_CHUNK_SIZE
+ * @candidate - an element used to pass candidates to the queue
+ * @result - the result queue
+ * @bound - see spKNNOffer
+ *
+ * @returns
+ * SP_KNN_OUT_OF_MEMORY if the queue failed to allocate an element, SP_KNN_SUCCESS otherwise
+ */
+SP_KNN_MSG spKNNOfferSelected(const double* query, int dim, SPDistanceBlockKernel kernel,
+		const double* const* rows,
+		const int* indices, const int* positions, int m, SPListElement candidate,
+		SPBPQueue result, double* bound) {
+	double distances[SP_KNN_CHUNK_SIZE];
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	int t;
+
+	spKNNSelectedDistances(query, dim, kernel, rows, positions, m, distances);
+	for (t = 0; t < m && msg == SP_KNN_SUCCESS; t++) {
+		if (distances[t] <= *bound)
+			msg = spKNNOffer(result, candidate, indices[positions[t]], distances[t], bound);
+	}
+	return msg;
+}
+
+// no neighbours found yet
+static inline SPKNNNearest spKNNNearestEmpty(void) {
+	SPKNNNearest nearest = { INFINITY, INT_MAX, INFINITY, INT_MAX };
+	return nearest;
+}
+
+/*
+ * updates the nearest points found so far with a point, without branches, so the
+ * compiler keeps the nearest points in registers and selects them by conditional moves
+ * @nearest - the nearest points, updated
+ * @index - the index of the point
+ * @distance - the distance of the point from the query
+ */
+static inline void spKNNNearestInsert(SPKNNNearest* nearest, int index, double distance) {
+	int first = (distance < nearest->firstDistance)
+			| ((distance == nearest->firstDistance) & (index < nearest->firstIndex));
+	int second = (distance < nearest->secondDistance)
+			| ((distance == nearest->secondDistance) & (index < nearest->secondIndex));
+
+	nearest->secondDistance = first ? nearest->firstDistance
+			: (second ? distance : nearest->secondDistance);
+	nearest->secondIndex = first ? nearest->firstIndex : (second ? index : nearest->secondIndex);
+	nearest->firstDistance = first ? distance : nearest->firstDistance;
+	nearest->firstIndex = first ? index : nearest->firstIndex;
+}
+
+// the distance a point must not exceed to be one of the k <= 2 nearest points
+static inline double spKNNNearestBound(const SPKNNNearest* nearest, int k) {
+	return k == 1 ? nearest->firstDistance : nearest->secondDistance;
+}
+
+/*
+ * updates the nearest points found so far with the points of a chunk. Most points are
+ * farther than the bound, so they are skipped by a well predicted branch, and only the
+ * others go through the branch free insertion.
+ * @nearest - the nearest points, updated
+ * @k - the number of neighbours
+ * @indices - the indices of the points of the chunk
+ * @positions - the positions of the points in the chunk, or NULL for all of them
+ * @distances - the distances of the points from the query
+ * @m - the number of points
+ */
+static inline void spKNNNearestUpdate(SPKNNNearest* nearest, int k, const int* indices,
+		const int* positions, const double* distances, int m) {
+	double bound = spKNNNearestBound(nearest, k);
+	int t;
+
+	for (t = 0; t < m; t++) {
+		if (distances[t] <= bound) {
+			spKNNNearestInsert(nearest, indices[positions == NULL ? t : positions[t]], distances[t]);
+			bound = spKNNNearestBound(nearest, k);
+		}
+	}
+}
+
+/*
+ * fills the result queue with the nearest points of a search of k <= SP_KNN_NEAREST_MAX_K
+ * neighbours
+ * @nearest - the nearest points
+ * @n - the number of searched points
+ * @candidate - an element used to pass the neighbours to the queue
+ * @result - the result queue, of capacity k
+ *
+ * @returns
+ * SP_KNN_OUT_OF_MEMORY if the queue failed to allocate an element, SP_KNN_SUCCESS otherwise
+ */
+static SP_KNN_MSG spKNNNearestFill(SPKNNNearest nearest, int n, SPListElement candidate,
+		SPBPQueue result) {
+	int k = spBPQueueGetMaxSize(result);
+
+	spBPQueueClear(result);
+	if (k >= 1 && n >= 1) {
+		spListElementSetIndex(candidate, nearest.firstIndex);
+		spListElementSetValue(candidate, nearest.firstDistance);
+		if (spBPQueueEnqueue(result, candidate) == SP_BPQUEUE_OUT_OF_MEMORY)
+			return SP_KNN_OUT_OF_MEMORY;
+	}
+	if (k >= 2 && n >= 2) {
+		spListElementSetIndex(candidate, nearest.secondIndex);
+		spListElementSetValue(candidate, nearest.secondDistance);
+		if (spBPQueueEnqueue(result, candidate) == SP_BPQUEUE_OUT_OF_MEMORY)
+			return SP_KNN_OUT_OF_MEMORY;
+	}
+	return SP_KNN_SUCCESS;
+}
+
+/*
+ * finds the k <= SP_KNN_NEAREST_MAX_K nearest points to a query among an array of
+ * points, as spKNNSearch without the result queue
+ * @query - the query
+ * @points - the points, of the dimension of the query
+ * @n - the number of points
+ * @k - the number of neighbours
+ * @kernel - the block kernel of the dimension, see spDistanceL2SquaredBlockFor
+ */
+static SPKNNNearest spKNNNearestOfPoints(SPPoint query, const SPPoint* points, int n, int k,
+		SPDistanceBlockKernel kernel) {
+	double distances[SP_KNN_CHUNK_SIZE];
+	double norms[SP_KNN_CHUNK_SIZE];
+	const double* rows[SP_KNN_CHUNK_SIZE];
+	int indices[SP_KNN_CHUNK_SIZE];
+	int positions[SP_KNN_CHUNK_SIZE];
+	SPKNNNearest nearest = spKNNNearestEmpty();
+	double queryLength = sqrt(spPointGetSquaredNormInline(query));
+	int i, j, count, m;
+
+	for (i = 0; i < n; i += SP_KNN_CHUNK_SIZE) {
+		count = n - i < SP_KNN_CHUNK_SIZE ? n - i : SP_KNN_CHUNK_SIZE;
+		for (j = 0; j < count; j++) {
+			norms[j] = spPointGetSquaredNormInline(points[i + j]);
+			indices[j] = points[i + j]->index;
+		}
+		m = spKNNFilter(norms, count, queryLength, query->dim, spKNNNearestBound(&nearest, k),
+				positions);
+		if (m < count) {
+			for (j = 0; j < count; j++)
+				rows[j] = points[i + j]->data;
+			spKNNSelectedDistances(query->data, query->dim, kernel, rows, positions, m, distances);
+			spKNNNearestUpdate(&nearest, k, indices, positions, distances, m);
+			continue;
+		}
+		spPointL2SquaredDistanceMany(query, points + i, count, distances);
+		spKNNNearestUpdate(&nearest, k, indices, NULL, distances, count);
+	}
+	return nearest;
+}
+
+SP_KNN_MSG spKNNSearch(SPPoint query, const SPPoint* points, int n, SPBPQueue result) {
+	double distances[SP_KNN_CHUNK_SIZE];
+	double norms[SP_KNN_CHUNK_SIZE];
+	const double* rows[SP_KNN_CHUNK_SIZE];
+	int indices[SP_KNN_CHUNK_SIZE];
+	int positions[SP_KNN_CHUNK_SIZE];
+	SPListElement candidate;
+	SPDistanceBlockKernel kernel;
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	double bound = DBL_MAX, queryLength;
+	int i, j, count, m;
+
+	if (query == NULL || points == NULL || result == NULL || n < 0)
+		return SP_KNN_INVALID_ARGUMENT;
+	for (i = 0; i < n; i++) {
+		if (points[i] == NULL || points[i]->dim != query->dim)
+			return SP_KNN_INVALID_ARGUMENT;
+	}
+	kernel = spDistanceL2SquaredBlockFor(query->dim);
+
+	candidate = spListElementCreate(0, 0.0);
+	if (candidate == NULL)
+		return SP_KNN_OUT_OF_MEMORY;
+
+	if (spBPQueueGetMaxSize(result) <= SP_KNN_NEAREST_MAX_K) {
+		msg = spKNNNearestFill(spKNNNearestOfPoints(query, points, n,
+				spBPQueueGetMaxSize(result), kernel), n, candidate, result);
+		spListElementDestroy(candidate);
+		return msg;
+	}
+
+	queryLength = sqrt(spPointGetSquaredNormInline(query));
+	spBPQueueClear(result);
+	for (i = 0; i < n && msg == SP_KNN_SUCCESS; i += SP_KNN_CHUNK_SIZE) {
+		count = n - i < SP_KNN_CHUNK_SIZE ? n - i : SP_KNN_CHUNK_SIZE;
+		for (j = 0; j < count; j++)
+			norms[j] = spPointGetSquaredNormInline(points[i + j]);
+		m = spKNNFilter(norms, count, queryLength, query->dim, bound, positions);
+		if (m < count) {
+			for (j = 0; j < count; j++) {
+				rows[j] = points[i + j]->data;
+				indices[j] = points[i + j]->index;
+			}
+			msg = spKNNOfferSelected(query->data, query->dim, kernel, rows, indices, positions,
+					m, candidate, result, &bound);
+			continue;
+		}
+		spPointL2SquaredDistanceMany(query, points + i, count, distances);
+		for (j = 0; j < count && msg == SP_KNN_SUCCESS; j++) {
+			if (distances[j] <= bound)
+				msg = spKNNOffer(result, candidate, points[i + j]->index, distances[j], &bound);
+		}
+	}
+
+	spListElementDestroy(candidate);
+	return msg;
+}
+
+/*
+ * finds the k <= SP_KNN_NEAREST_MAX_K nearest points to a query among the points of a
+ * store, as spKNNScanStore without the result queue
+ * @store - the searched store
+ * @query - the coordinates of the query
+ * @queryNorm - the squared norm of the query
+ * @k - the number of neighbours
+ */
+static SPKNNNearest spKNNNearestOfStore(SPPointStore store, const double* query, double queryNorm,
+		int k) {
+	double distances[SP_KNN_CHUNK_SIZE];
+	const double* rows[SP_KNN_CHUNK_SIZE];
+	int positions[SP_KNN_CHUNK_SIZE];
+	SPKNNNearest nearest = spKNNNearestEmpty();
+	double queryLength = sqrt(queryNorm);
+	int i, j, count, m;
+
+	for (i = 0; i < store->size; i += SP_KNN_CHUNK_SIZE) {
+		count = store->size - i < SP_KNN_CHUNK_SIZE ? store->size - i : SP_KNN_CHUNK_SIZE;
+		if (store->precision == SP_POINT_STORE_HALF) {
+			spDistanceL2SquaredHalfStrided(query, spPointStoreGetHalfRowInline(store, i), count,
+					store->dim, store->stride, distances);
+		} else {
+			m = spKNNFilter(store->norms + i, count, queryLength, store->dim,
+					spKNNNearestBound(&nearest, k), positions);
+			if (m < count) {
+				for (j = 0; j < count; j++)
+					rows[j] = spPointStoreGetRowInline(store, i + j);
+				spKNNSelectedDistances(query, store->dim, store->l2Block, rows, positions, m,
+						distances);
+				spKNNNearestUpdate(&nearest, k, store->indices + i, positions, distances, m);
+				continue;
+			}
+			store->l2Strided(query, spPointStoreGetRowInline(store, i), count, store->dim,
+					store->stride, distances);
+		}
+		spKNNNearestUpdate(&nearest, k, store->indices + i, NULL, distances, count);
+	}
+	return nearest;
+}
+
+/*
+ * fills the result queue with the nearest neighbours of a query among the points of a store
+ * @store - the searched store
+ * @query - the coordinates of the query
+ * @queryNorm - the squared norm of the query
+ * @candidate - an element used to pass candidates to the queue
+ * @result - the result queue
+ *
+ * @returns
+ * SP_KNN_OUT_OF_MEMORY if the queue failed to allocate an element, SP_KNN_SUCCESS otherwise
+ */
+SP_KNN_MSG spKNNScanStore(SPPointStore store, const double* query, double queryNorm,
+		SPListElement candidate, SPBPQueue result) {
+	double distances[SP_KNN_CHUNK_SIZE];
+	const double* rows[SP_KNN_CHUNK_SIZE];
+	int positions[SP_KNN_CHUNK_SIZE];
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	double bound = DBL_MAX, queryLength = sqrt(queryNorm);
+	int i, j, count, m;
+
+	if (spBPQueueGetMaxSize(result) <= SP_KNN_NEAREST_MAX_K)
+		return spKNNNearestFill(spKNNNearestOfStore(store, query, queryNorm,
+				spBPQueueGetMaxSize(result)), store->size, candidate, result);
+
+	spBPQueueClear(result);
+	for (i = 0; i < store->size && msg == SP_KNN_SUCCESS; i += SP_KNN_CHUNK_SIZE) {
+		count = store->size - i < SP_KNN_CHUNK_SIZE ? store->size - i : SP_KNN_CHUNK_SIZE;
+		// the single precision distances of a half store are not pruned by the norms,
+		// whose error bounds are those of double precision
+		if (store->precision == SP_POINT_STORE_HALF) {
+			spDistanceL2SquaredHalfStrided(query, spPointStoreGetHalfRowInline(store, i), count,
+					store->dim, store->stride, distances);
+		} else {
+			m = spKNNFilter(store->norms + i, count, queryLength, store->dim, bound, positions);
+			if (m < count) {
+				for (j = 0; j < count; j++)
+					rows[j] = spPointStoreGetRowInline(store, i + j);
+				msg = spKNNOfferSelected(query, store->dim, store->l2Block, rows,
+						store->indices + i, positions, m, candidate, result, &bound);
+				continue;
+			}
+			store->l2Strided(query, spPointStoreGetRowInline(store, i), count, store->dim,
+					store->stride, distances);
+		}
+		for (j = 0; j < count && msg == SP_KNN_SUCCESS; j++) {
+			if (distances[j] <= bound)
+				msg = spKNNOffer(result, candidate, store->indices[i + j], distances[j], &bound);
+		}
+	}
+	return msg;
+}
+
+SP_KNN_MSG spKNNSearchStore(SPPointStore store, SPPoint query, SPBPQueue result) {
+	SPListElement candidate;
+	SP_KNN_MSG msg;
+
+	if (store == NULL || query == NULL || result == NULL || query->dim != store->dim)
+		return SP_KNN_INVALID_ARGUMENT;
+
+	candidate = spListElementCreate(0, 0.0);
+	if (candidate == NULL)
+		return SP_KNN_OUT_OF_MEMORY;
+
+	msg = spKNNScanStore(store, query->data, spPointGetSquaredNormInline(query), candidate, result);
+
+	spListElementDestroy(candidate);
+	return msg;
+}
+
+/*
+ * the coordinates of the i-th point of a store as doubles
+ * @store - the store
+ * @i - the position of the point
+ * @buffer - dim(store) doubles, which receive the coordinates of a half precision store
+ */
+static inline const double* spKNNStoreRow(SPPointStore store, int i, double* buffer) {
+	const uint16_t* row;
+	int axis;
+
+	if (store->precision != SP_POINT_STORE_HALF)
+		return spPointStoreGetRowInline(store, i);
+	row = spPointStoreGetHalfRowInline(store, i);
+	for (axis = 0; axis < store->dim; axis++)
+		buffer[axis] = spDistanceHalfToFloat(row[axis]);
+	return buffer;
+}
+
+/*
+ * the value of a point in the queue of a search by a metric other than SP_KNN_L2_SQUARED
+ * @metric - the metric of the search
+ * @query - the coordinates of the query
+ * @queryNorm - the squared norm of the query
+ * @row - the coordinates of the point
+ * @norm - the squared norm of the point
+ * @dim - the dimension of the points
+ * @shift - the value of a point of inner product 0 for SP_KNN_INNER_PRODUCT
+ */
+static inline double spKNNMetricValue(SP_KNN_METRIC metric, const double* query, double queryNorm,
+		const double* row, double norm, int dim, double shift) {
+	double value;
+
+	switch (metric) {
+	case SP_KNN_L1:
+		return spDistanceL1(query, row, dim);
+	case SP_KNN_INNER_PRODUCT:
+		value = shift - spDistanceInnerProduct(query, row, dim);
+		// by Cauchy-Schwarz only the rounding may make it negative
+		return value > 0.0 ? value : 0.0;
+	default:
+		return spDistanceCosine(spDistanceInnerProduct(query, row, dim), queryNorm, norm);
+	}
+}
+
+// true if metric is a metric of spKNNSearchMetric
+static inline bool spKNNIsMetric(SP_KNN_METRIC metric) {
+	return metric == SP_KNN_L2_SQUARED || metric == SP_KNN_L1 || metric == SP_KNN_INNER_PRODUCT
+			|| metric == SP_KNN_COSINE;
+}
+
+SP_KNN_MSG spKNNSearchMetric(SPPoint query, const SPPoint* points, int n, SP_KNN_METRIC metric,
+		SPBPQueue result) {
+	SPListElement candidate;
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	double bound = DBL_MAX, queryNorm, maxNorm = 0.0, norm, shift, value;
+	int i;
+
+	if (!spKNNIsMetric(metric))
+		return SP_KNN_INVALID_ARGUMENT;
+	if (metric == SP_KNN_L2_SQUARED)
+		return spKNNSearch(query, points, n, result);
+	if (query == NULL || points == NULL || result == NULL || n < 0)
+		return SP_KNN_INVALID_ARGUMENT;
+	for (i = 0; i < n; i++) {
+		if (points[i] == NULL || points[i]->dim != query->dim)
+			return SP_KNN_INVALID_ARGUMENT;
+		norm = spPointGetSquaredNormInline(points[i]);
+		maxNorm = norm > maxNorm ? norm : maxNorm;
+	}
+
+	candidate = spListElementCreate(0, 0.0);
+	if (candidate == NULL)
+		return SP_KNN_OUT_OF_MEMORY;
+
+	queryNorm = spPointGetSquaredNormInline(query);
+	shift = sqrt(queryNorm * maxNorm);
+	spBPQueueClear(result);
+	for (i = 0; i < n && msg == SP_KNN_SUCCESS; i++) {
+		if (i + 1 < n)
+			spDistancePrefetch(points[i + 1]->data);
+		value = spKNNMetricValue(metric, query->data, queryNorm, points[i]->data,
+				spPointGetSquaredNormInline(points[i]), query->dim, shift);
+		if (value <= bound)
+			msg = spKNNOffer(result, candidate, points[i]->index, value, &bound);
+	}
+
+	spListElementDestroy(candidate);
+	return msg;
+}
+
+SP_KNN_MSG spKNNSearchStoreMetric(SPPointStore store, SPPoint query, SP_KNN_METRIC metric,
+		SPBPQueue result) {
+	SPListElement candidate;
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	double bound = DBL_MAX, queryNorm, maxNorm = 0.0, shift, value;
+	double* buffer = NULL;
+	int i;
+
+	if (!spKNNIsMetric(metric))
+		return SP_KNN_INVALID_ARGUMENT;
+	if (metric == SP_KNN_L2_SQUARED)
+		return spKNNSearchStore(store, query, result);
+	if (store == NULL || query == NULL || result == NULL || query->dim != store->dim)
+		return SP_KNN_INVALID_ARGUMENT;
+	for (i = 0; i < store->size; i++)
+		maxNorm = store->norms[i] > maxNorm ? store->norms[i] : maxNorm;
+
+	candidate = spListElementCreate(0, 0.0);
+	if (store->precision == SP_POINT_STORE_HALF)
+		buffer = (double*) malloc(sizeof(double) * (size_t) store->dim);
+	if (candidate == NULL || (store->precision == SP_POINT_STORE_HALF && buffer == NULL)) {
+		spListElementDestroy(candidate);
+		free(buffer);
+		return SP_KNN_OUT_OF_MEMORY;
+	}
+
+	queryNorm = spPointGetSquaredNormInline(query);
+	shift = sqrt(queryNorm * maxNorm);
+	spBPQueueClear(result);
+	for (i = 0; i < store->size && msg == SP_KNN_SUCCESS; i++) {
+		value = spKNNMetricValue(metric, query->data, queryNorm, spKNNStoreRow(store, i, buffer),
+				store->norms[i], store->dim, shift);
+		if (value <= bound)
+			msg = spKNNOffer(result, candidate, store->indices[i], value, &bound);
+	}
+
+	spListElementDestroy(candidate);
+	free(buffer);
+	return msg;
+}
+
+SP_KNN_MSG spKNNSearchBinary(SPBinaryPoint query, const SPBinaryPoint* points, int n,
+		SPBPQueue result) {
+	SPListElement candidate;
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	double bound = DBL_MAX, distance;
+	int i, words;
+
+	if (query == NULL || points == NULL || result == NULL || n < 0)
+		return SP_KNN_INVALID_ARGUMENT;
+	for (i = 0; i < n; i++) {
+		if (points[i] == NULL || points[i]->bits != query->bits)
+			return SP_KNN_INVALID_ARGUMENT;
+	}
+
+	candidate = spListElementCreate(0, 0.0);
+	if (candidate == NULL)
+		return SP_KNN_OUT_OF_MEMORY;
+
+	words = spBinaryPointWordsCount(query->bits);
+	spBPQueueClear(result);
+	for (i = 0; i < n && msg == SP_KNN_SUCCESS; i++) {
+		// the headers and words of the next points are loaded while this one is counted
+		if (i + SP_DISTANCE_BLOCK_SIZE < n)
+			spDistancePrefetch(points[i + SP_DISTANCE_BLOCK_SIZE]);
+		distance = spDistanceHamming(query->words, points[i]->words, words);
+		if (distance <= bound)
+			msg = spKNNOffer(result, candidate, points[i]->index, distance, &bound);
+	}
+
+	spListElementDestroy(candidate);
+	return msg;
+}
+
+/*
+ * fills the result queue of a query of a batch search from its row of the distance matrix
+ * @store - the searched store
+ * @query - the coordinates of the query
+ * @queryNorm - the squared norm of the query
+ * @maxNorm - the maximal squared norm of the points of store
+ * @distances - the distances of the query from the points of store
+ * @accuracy - the accuracy of the search
+ * @candidate - an element used to pass candidates to the queue
+ * @result - the result queue
+ *
+ * @returns
+ * SP_KNN_OUT_OF_MEMORY if the queue failed to allocate an element, SP_KNN_SUCCESS otherwise
+ */
+SP_KNN_MSG spKNNSelect(SPPointStore store, const double* query, double queryNorm, double maxNorm,
+		const double* distances, SP_KNN_ACCURACY accuracy, SPListElement candidate,
+		SPBPQueue result) {
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	double bound = DBL_MAX, threshold, distance;
+	int j;
+
+	spBPQueueClear(result);
+	for (j = 0; j < store->size && msg == SP_KNN_SUCCESS; j++) {
+		if (distances[j] <= bound)
+			msg = spKNNOffer(result, candidate, store->indices[j], distances[j], &bound);
+	}
+	if (accuracy == SP_KNN_FAST || msg != SP_KNN_SUCCESS)
+		return msg;
+
+	// every point whose exact distance may be in the top k is within twice the
+	// error bound of the approximate k-th distance
+	threshold = bound;
+	if (bound != DBL_MAX)
+		threshold += 2.0 * spDistanceL2SquaredMatrixError(queryNorm, maxNorm, store->dim);
+	bound = DBL_MAX;
+	spBPQueueClear(result);
+	for (j = 0; j < store->size && msg == SP_KNN_SUCCESS; j++) {
+		if (distances[j] > threshold)
+			continue;
+		distance = spDistanceL2Squared(query, spPointStoreGetRowInline(store, j), store->dim);
+		if (distance <= bound)
+			msg = spKNNOffer(result, candidate, store->indices[j], distance, &bound);
+	}
+	return msg;
+}
+
+/*
+ * the batch search of stores of which at least one is of half precision, every query
+ * is searched by itself as in spKNNSearchStore
+ * @store - the searched store
+ * @queries - the store of the queries
+ * @results - the result queues
+ *
+ * @returns
+ * SP_KNN_OUT_OF_MEMORY in case of memory allocation failure, SP_KNN_SUCCESS otherwise
+ */
+SP_KNN_MSG spKNNSearchBatchHalf(SPPointStore store, SPPointStore queries, SPBPQueue* results) {
+	SPListElement candidate = spListElementCreate(0, 0.0);
+	double* buffer = (double*) malloc(sizeof(double) * (size_t) queries->dim);
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	int i;
+
+	if (candidate == NULL || buffer == NULL) {
+		spListElementDestroy(candidate);
+		free(buffer);
+		return SP_KNN_OUT_OF_MEMORY;
+	}
+	for (i = 0; i < queries->size && msg == SP_KNN_SUCCESS; i++)
+		msg = spKNNScanStore(store, spKNNStoreRow(queries, i, buffer), queries->norms[i], candidate,
+				results[i]);
+
+	spListElementDestroy(candidate);
+	free(buffer);
+	return msg;
+}
+
+SP_KNN_MSG spKNNSearchBatch(SPPointStore store, SPPointStore queries, SP_KNN_ACCURACY accuracy,
+		SPBPQueue* results) {
+	SPListElement candidate;
+	SP_KNN_MSG msg = SP_KNN_SUCCESS;
+	double* distances;
+	double maxNorm = 0.0;
+	int i, j, count;
+
+	if (store == NULL || queries == NULL || results == NULL || queries->dim != store->dim)
+		return SP_KNN_INVALID_ARGUMENT;
+	for (i = 0; i < queries->size; i++) {
+		if (results[i] == NULL)
+			return SP_KNN_INVALID_ARGUMENT;
+	}
+	for (j = 0; j < store->size; j++) {
+		if (store->norms[j] > maxNorm)
+			maxNorm = store->norms[j];
+	}
+
+	if (store->precision == SP_POINT_STORE_HALF || queries->precision == SP_POINT_STORE_HALF)
+		return spKNNSearchBatchHalf(store, queries, results);
+
+	candidate = spListElementCreate(0, 0.0);
+	distances = (double*) malloc(sizeof(double) * SP_KNN_QUERY_BLOCK_SIZE * (size_t) store->size);
+	if (candidate == NULL || distances == NULL) {
+		spListElementDestroy(candidate);
+		free(distances);
+		return SP_KNN_OUT_OF_MEMORY;
+	}
+
+	for (i = 0; i < queries->size && msg == SP_KNN_SUCCESS; i += SP_KNN_QUERY_BLOCK_SIZE) {
+		count = queries->size - i < SP_KNN_QUERY_BLOCK_SIZE ? queries->size - i : SP_KNN_QUERY_BLOCK_SIZE;
+		spPointStoreL2SquaredDistanceMatrix(queries, i, count, store, distances);
+		for (j = 0; j < count && msg == SP_KNN_SUCCESS; j++)
+			msg = spKNNSelect(store, spPointStoreGetRowInline(queries, i + j), queries->norms[i + j],
+					maxNorm, distances + (size_t) j * (size_t) store->size, accuracy, candidate,
+					results[i + j]);
+	}
+
+	spListElementDestroy(candidate);
+	free(distances);
+	return msg;
+}
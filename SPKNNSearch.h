@@ -0,0 +1,172 @@
+#ifndef SPKNNSEARCH_H_
+#define SPKNNSEARCH_H_
+
+#include "SPBPriorityQueue.h"
+#include "SPPoint.h"
+#include "SPPointStore.h"
+#include "SPBinaryPoint.h"
+
+/**
+ * SP k Nearest Neighbours Search summary
+ *
+ * Finds the k points nearest to a query by the L2 squared distance, where k is
+ * the capacity of a given SPBPQueue. The result queue is cleared and filled with
+ * one element per neighbour, whose index is the index of the point and whose
+ * value is its distance from the query, so the nearest neighbour is the minimal
+ * element of the queue. Points at the same distance are ordered by their index,
+ * as in SPBPQueue.
+ *
+ * The single query searches skip the points whose cached squared norms prove
+ * they are farther than the current k-th neighbour, by the bound
+ * (||q|| - ||p||)^2 <= ||q - p||^2, without changing the results. When k <= 2 they
+ * keep the nearest points in locals instead of the queue, which receives them at the
+ * end of the search, so searching the nearest neighbour or the two nearest (for a
+ * ratio test) costs little more than computing the distances.
+ *
+ * The following functions are available:
+ *
+ *   spKNNSearch            - Finds the nearest neighbours of a query among an array of points
+ *   spKNNSearchStore       - Finds the nearest neighbours of a query among the points of a store
+ *   spKNNSearchBatch       - Finds the nearest neighbours of every point of a store of queries
+ *                            among the points of a store
+ *   spKNNSearchMetric      - Finds the nearest neighbours of a query among an array of points
+ *                            by a given metric
+ *   spKNNSearchStoreMetric - Finds the nearest neighbours of a query among the points of a store
+ *                            by a given metric
+ *   spKNNSearchBinary      - Finds the nearest neighbours of a binary query among an array of
+ *                            binary points by the Hamming distance
+ */
+
+/** type for error reporting **/
+typedef enum sp_knn_msg_t {
+	SP_KNN_OUT_OF_MEMORY,
+	SP_KNN_INVALID_ARGUMENT,
+	SP_KNN_SUCCESS
+} SP_KNN_MSG;
+
+/** type used to choose the accuracy of a batch search **/
+typedef enum sp_knn_accuracy_t {
+	SP_KNN_FAST, // the distances of the norm decomposition, which may be slightly off
+	SP_KNN_EXACT // the same neighbours and distances as a search of every query by itself
+} SP_KNN_ACCURACY;
+
+/** type used to choose the metric of a search **/
+typedef enum sp_knn_metric_t {
+	SP_KNN_L2_SQUARED, // spPointL2SquaredDistance
+	SP_KNN_L1, // spPointL1Distance
+	SP_KNN_INNER_PRODUCT, // the maximal inner product is the nearest, see spKNNSearchMetric
+	SP_KNN_COSINE // spPointCosineDistance
+} SP_KNN_METRIC;
+
+/**
+ * Finds the nearest neighbours of query among the n given points.
+ *
+ * @param query - The query point
+ * @param points - The points to search, n points with the dimension of query
+ * @param n - The number of points
+ * @param result - The queue which receives the neighbours, its capacity is k
+ * @return
+ * SP_KNN_INVALID_ARGUMENT - if query, points or result is NULL, n < 0, or a point is NULL
+ *                           or has another dimension
+ * SP_KNN_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_KNN_SUCCESS - otherwise
+ */
+SP_KNN_MSG spKNNSearch(SPPoint query, const SPPoint* points, int n, SPBPQueue result);
+
+/**
+ * Finds the nearest neighbours of query among the points of store.
+ *
+ * @param store - The store to search
+ * @param query - The query point
+ * @param result - The queue which receives the neighbours, its capacity is k
+ * @return
+ * SP_KNN_INVALID_ARGUMENT - if store, query or result is NULL, or the dimension of
+ *                           query is not the dimension of store
+ * SP_KNN_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_KNN_SUCCESS - otherwise
+ */
+SP_KNN_MSG spKNNSearchStore(SPPointStore store, SPPoint query, SPBPQueue result);
+
+/**
+ * Finds the nearest neighbours of every point of queries among the points of store,
+ * results[i] receives the neighbours of the i-th query.
+ *
+ * The distances are computed for blocks of queries at once by
+ * spPointStoreL2SquaredDistanceMatrix. With SP_KNN_EXACT the candidates which may
+ * belong to the top k, given the error bound of the decomposition, have their
+ * distances recomputed exactly, so the results are those of spKNNSearchStore.
+ * If store or queries is a SP_POINT_STORE_HALF store, every query is searched by
+ * itself as in spKNNSearchStore, whatever the accuracy.
+ *
+ * @param store - The store to search
+ * @param queries - The store of the queries
+ * @param accuracy - The accuracy of the distances
+ * @param results - size(queries) queues, each receives the neighbours of its query
+ * @return
+ * SP_KNN_INVALID_ARGUMENT - if store, queries, results or one of the results is NULL,
+ *                           or the dimensions of the stores are not equal
+ * SP_KNN_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_KNN_SUCCESS - otherwise
+ */
+SP_KNN_MSG spKNNSearchBatch(SPPointStore store, SPPointStore queries, SP_KNN_ACCURACY accuracy,
+		SPBPQueue* results);
+
+/**
+ * Finds the nearest neighbours of query among the n given points by metric.
+ * SP_KNN_L2_SQUARED is the search of spKNNSearch.
+ *
+ * The values of the queue must not be negative, so with SP_KNN_INNER_PRODUCT the
+ * value of a point p is ||query|| * M - query.p, where M is the maximal norm of the
+ * points, and the neighbours are the points of the maximal inner products.
+ * The cosine distances use the cached norms of the points.
+ *
+ * @param query - The query point
+ * @param points - The points to search, n points with the dimension of query
+ * @param n - The number of points
+ * @param metric - The metric of the search
+ * @param result - The queue which receives the neighbours, its capacity is k
+ * @return
+ * SP_KNN_INVALID_ARGUMENT - if query, points or result is NULL, n < 0, a point is NULL
+ *                           or has another dimension, or metric is not a SP_KNN_METRIC
+ * SP_KNN_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_KNN_SUCCESS - otherwise
+ */
+SP_KNN_MSG spKNNSearchMetric(SPPoint query, const SPPoint* points, int n, SP_KNN_METRIC metric,
+		SPBPQueue result);
+
+/**
+ * Finds the nearest neighbours of query among the points of store by metric,
+ * see spKNNSearchMetric. SP_KNN_L2_SQUARED is the search of spKNNSearchStore.
+ *
+ * @param store - The store to search
+ * @param query - The query point
+ * @param metric - The metric of the search
+ * @param result - The queue which receives the neighbours, its capacity is k
+ * @return
+ * SP_KNN_INVALID_ARGUMENT - if store, query or result is NULL, the dimension of query
+ *                           is not the dimension of store, or metric is not a SP_KNN_METRIC
+ * SP_KNN_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_KNN_SUCCESS - otherwise
+ */
+SP_KNN_MSG spKNNSearchStoreMetric(SPPointStore store, SPPoint query, SP_KNN_METRIC metric,
+		SPBPQueue result);
+
+/**
+ * Finds the nearest neighbours of query among the n given binary points by the
+ * Hamming distance (spBinaryPointHammingDistance), the value of a neighbour is
+ * its Hamming distance from query.
+ *
+ * @param query - The query binary point
+ * @param points - The binary points to search, n points with the bits of query
+ * @param n - The number of points
+ * @param result - The queue which receives the neighbours, its capacity is k
+ * @return
+ * SP_KNN_INVALID_ARGUMENT - if query, points or result is NULL, n < 0, or a point is NULL
+ *                           or has another number of bits
+ * SP_KNN_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_KNN_SUCCESS - otherwise
+ */
+SP_KNN_MSG spKNNSearchBinary(SPBinaryPoint query, const SPBinaryPoint* points, int n,
+		SPBPQueue result);
+
+#endif /* SPKNNSEARCH_H_ */
@@ -1,12 +1,15 @@
-#include "SPListElement.h"
+#include "SPListElementInternal.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
-struct sp_list_element_t {
-	int index;
-	double value;
-};
+// The number of bits of the key sorted by each pass of the radix sort
+#define SP_LIST_ELEMENT_RADIX_BITS 8
+#define SP_LIST_ELEMENT_RADIX_BUCKETS (1 << SP_LIST_ELEMENT_RADIX_BITS)
+#define SP_LIST_ELEMENT_RADIX_PASSES (64 / SP_LIST_ELEMENT_RADIX_BITS)
+// The minimal number of elements sorted by the radix sort, smaller arrays are insertion
+// sorted, and so are the smaller runs of elements which share the high half of their keys
+#define SP_LIST_ELEMENT_RADIX_MIN_SIZE 64
 
 SPListElement spListElementCreate(int index, double value) {
 	SPListElement temp = NULL;
@@ -52,10 +55,7 @@ SP_ELEMENT_MSG spListElementSetIndex(SPListElement data, int index) {
 }
 
 int spListElementGetIndex(SPListElement data) {
-	if(data == NULL){
-		return -1;
-	}
-	return data->index;
+	return spListElementGetIndexInline(data);
 }
 
 SP_ELEMENT_MSG spListElementSetValue(SPListElement data, double newValue) {
@@ -67,18 +67,106 @@ SP_ELEMENT_MSG spListElementSetValue(SPListElement data, double newValue) {
 }
 
 double spListElementGetValue(SPListElement data) {
-	if(data == NULL){
-		return -1.0;
-	}
-	return data->value;
+	return spListElementGetValueInline(data);
 }
 
 int spListElementCompare(SPListElement e1, SPListElement e2){
-	assert(e1!=NULL && e2!=NULL);
-	if(e1->value == e2->value){
-		return e1->index - e2->index;
-	}else if(e1->value > e2->value){
-		return 1;
+	return spListElementCompareInline(e1, e2);
+}
+
+uint64_t spListElementGetKey(SPListElement data) {
+	assert(data != NULL);
+	return spListElementKeyInline(data);
+}
+
+/*
+ * sorts an array of elements by insertion, which is linear for an array whose
+ * elements are only a few positions away from their places
+ * @items - the elements
+ * @n - the number of elements
+ */
+static void spListElementInsertionSort(struct sp_list_element_t* items, int n) {
+	struct sp_list_element_t item;
+	int i, j;
+
+	for (i = 1; i < n; i++) {
+		item = items[i];
+		for (j = i; j > 0 && spListElementCompareInline(&item, items + j - 1) < 0; j--)
+			items[j] = items[j - 1];
+		items[j] = item;
+	}
+}
+
+// compares two elements for qsort
+static int spListElementCompareItems(const void* a, const void* b) {
+	return spListElementCompareInline((SPListElement) a, (SPListElement) b);
+}
+
+/*
+ * restores the order of spListElementCompare in an array sorted by the keys of its
+ * elements, where the elements whose values round to the same key are in the order of
+ * their indices
+ * @items - the elements
+ * @n - the number of elements
+ */
+static void spListElementSortKeyRuns(struct sp_list_element_t* items, int n) {
+	uint64_t high;
+	int i, j;
+
+	for (i = 0; i < n; i = j) {
+		high = spListElementKeyInline(items + i) >> 32;
+		for (j = i + 1; j < n && spListElementKeyInline(items + j) >> 32 == high; j++)
+			;
+		if (j - i < SP_LIST_ELEMENT_RADIX_MIN_SIZE)
+			spListElementInsertionSort(items + i, j - i);
+		else // such as values beyond FLT_MAX
+			qsort(items + i, (size_t) (j - i), sizeof(struct sp_list_element_t),
+					spListElementCompareItems);
+	}
+}
+
+// the digit of a key sorted by a pass of the radix sort
+static inline int spListElementRadixDigit(uint64_t key, int pass) {
+	return (int) ((key >> (pass * SP_LIST_ELEMENT_RADIX_BITS)) & (SP_LIST_ELEMENT_RADIX_BUCKETS - 1));
+}
+
+void spListElementSortItems(struct sp_list_element_t* items, int n,
+		struct sp_list_element_t* scratch) {
+	int counts[SP_LIST_ELEMENT_RADIX_PASSES][SP_LIST_ELEMENT_RADIX_BUCKETS];
+	struct sp_list_element_t *from = items, *to = scratch, *temp;
+	uint64_t key;
+	int i, pass, digit, offset, count;
+
+	assert(n <= 0 || (items != NULL && scratch != NULL));
+	if (n < SP_LIST_ELEMENT_RADIX_MIN_SIZE) {
+		spListElementInsertionSort(items, n);
+		return;
+	}
+
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < n; i++) {
+		key = spListElementKeyInline(items + i);
+		for (pass = 0; pass < SP_LIST_ELEMENT_RADIX_PASSES; pass++)
+			counts[pass][spListElementRadixDigit(key, pass)]++;
+	}
+	for (pass = 0; pass < SP_LIST_ELEMENT_RADIX_PASSES; pass++) {
+		// a digit shared by all the keys, such as the high bytes of small indices, keeps the order
+		if (counts[pass][spListElementRadixDigit(spListElementKeyInline(from), pass)] == n)
+			continue;
+		for (digit = 0, offset = 0; digit < SP_LIST_ELEMENT_RADIX_BUCKETS; digit++) {
+			count = counts[pass][digit];
+			counts[pass][digit] = offset;
+			offset += count;
+		}
+		for (i = 0; i < n; i++) {
+			digit = spListElementRadixDigit(spListElementKeyInline(from + i), pass);
+			to[counts[pass][digit]++] = from[i];
+		}
+		temp = from;
+		from = to;
+		to = temp;
 	}
-	return -1;
+	if (from != items)
+		memcpy(items, from, sizeof(struct sp_list_element_t) * (size_t) n);
+	spListElementSortKeyRuns(items, n);
 }
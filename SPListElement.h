@@ -1,6 +1,8 @@
 #ifndef LISTELEMENT_H_
 #define LISTELEMENT_H_
 
+#include <stdint.h>
+
 /**
  * List Element Summary
  *
@@ -20,6 +22,7 @@
  *	spListElementCopy 	   - Creates a new copy of the target element
  *	spListElementDestroy   - Free all memory allocations associated with an element
  *	spListElementcompare   - Compares two elements
+ *	spListElementGetKey    - Gets an integer key which orders elements as spListElementCompare
  *	spListElementSetIndex  - Sets a new index to the target element
  *  spListElementGetIndex  - Gets a the index of the target  element
  *  spListElementSetValue  - Sets a new value to the target element.
@@ -92,6 +95,24 @@ void spListElementDestroy(SPListElement data);
  */
 int spListElementCompare(SPListElement e1, SPListElement e2);
 
+/**
+ * Gets a 64 bit key of an element, whose high 32 bits are the bits of its value
+ * rounded toward zero to single precision (values beyond FLT_MAX are FLT_MAX), and
+ * whose low 32 bits are its index. Since values are not negative, the rounding
+ * keeps their order and the keys compare as unsigned integers in the order of
+ * spListElementCompare, up to the rounding:
+ * 		if the high halves of the keys differ, e1 is less than e2 iff key(e1) < key(e2),
+ * 		otherwise the values round to the same single precision value, and the
+ * 		elements must be compared by spListElementCompare.
+ * The keys of elements with values exact in single precision are ordered exactly.
+ *
+ * @param data The target element
+ * @assert data != NULL
+ * @return
+ * The key of the element
+ */
+uint64_t spListElementGetKey(SPListElement data);
+
 /**
  * 	A setter for the index of the target element.
  *  The new index must be greater or equal to 0
@@ -0,0 +1,85 @@
+#ifndef SPLISTELEMENTINTERNAL_H_
+#define SPLISTELEMENTINTERNAL_H_
+
+#include "SPListElement.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <float.h>
+
+/**
+ * List Element internal summary
+ *
+ * Exposes the layout of SPListElement and inline variants of its hot accessors
+ * to the trusted modules of this library (SPList, SPBPriorityQueue and the search
+ * code), so the compiler can inline them into their loops.
+ * External users must include SPListElement.h only, the layout is not part of the API.
+ *
+ * The inline variants have the same semantics as the corresponding functions:
+ *   spListElementGetIndexInline  - see spListElementGetIndex
+ *   spListElementGetValueInline  - see spListElementGetValue
+ *   spListElementCompareInline   - see spListElementCompare
+ *   spListElementKeyInline       - see spListElementGetKey
+ *
+ * It also sorts arrays of element structures, see spListElementSortItems.
+ */
+
+/*
+ * A structure used for the element data type
+ * index - the index of the element
+ * value - the value of the element
+ */
+struct sp_list_element_t {
+	int index;
+	double value;
+};
+
+static inline int spListElementGetIndexInline(SPListElement data) {
+	if (data == NULL) {
+		return -1;
+	}
+	return data->index;
+}
+
+static inline double spListElementGetValueInline(SPListElement data) {
+	if (data == NULL) {
+		return -1.0;
+	}
+	return data->value;
+}
+
+static inline int spListElementCompareInline(SPListElement e1, SPListElement e2) {
+	int byValue, byIndex;
+	assert(e1 != NULL && e2 != NULL);
+	byValue = (e1->value > e2->value) - (e1->value < e2->value);
+	byIndex = (e1->index > e2->index) - (e1->index < e2->index);
+	return byValue != 0 ? byValue : byIndex;
+}
+
+static inline uint64_t spListElementKeyInline(SPListElement data) {
+	union {
+		float value;
+		uint32_t bits;
+	} rounded;
+	// values beyond FLT_MAX share the key of FLT_MAX instead of overflowing the conversion
+	double value = data->value < FLT_MAX ? data->value : FLT_MAX;
+
+	rounded.value = (float) value;
+	// the bits of non-negative floats are ordered as the floats, so stepping down a
+	// rounded up value rounds toward zero and the keys never reverse the order of values
+	rounded.bits -= (double) rounded.value > value;
+	return ((uint64_t) rounded.bits << 32) | (uint32_t) data->index;
+}
+
+/*
+ * sorts an array of elements in the order of spListElementCompare. Large arrays are
+ * sorted by a radix sort of their keys (see spListElementGetKey), and then every run of
+ * elements whose values share the high half of their keys is sorted exactly.
+ * @items - the elements
+ * @n - the number of elements
+ * @scratch - room for n elements, whose content is overwritten
+ */
+void spListElementSortItems(struct sp_list_element_t* items, int n,
+		struct sp_list_element_t* scratch);
+
+#endif /* SPLISTELEMENTINTERNAL_H_ */
@@ -1,8 +1,16 @@
+#define _POSIX_C_SOURCE 200809L
 #include "SPLogger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define ERROR_MSG "---ERROR---\n"
 #define WARNING_MSG  "---WARNING---\n"
@@ -11,10 +19,78 @@
 
 #define GENERAL_MESSAGE_SKELETON "%s- file: %s\n- function: %s\n- line: %d\n- message: %s"
 #define SHORT_MESSAGE_SKELETON "%s- message: %s"
+#define TIMED_GENERAL_MESSAGE_SKELETON "%s- time: %lld.%09ld\n- file: %s\n- function: %s\n- line: %d\n- message: %s"
+#define TIMED_SHORT_MESSAGE_SKELETON "%s- time: %lld.%09ld\n- message: %s"
+#define NANOSECONDS_IN_SECOND 1000000000L
 
 //File open mode
 #define SP_LOGGER_OPEN_MODE "w"
 
+//Segment files permissions and the format of the rotated segment names
+#define SP_LOGGER_SEGMENT_MODE 0644
+#define SP_LOGGER_SEGMENT_NAME_FORMAT "%s.%d"
+#define SP_LOGGER_SEGMENT_NAME_SUFFIX_SIZE 12
+
+//Size of the stack buffer a record is formatted into before it is copied to a segment
+#define SP_LOGGER_RECORD_BUFFER_SIZE 1024
+
+//Number of call sites tracked by the rate limit and sampling (must be a power of 2)
+#define SP_LOGGER_CALL_SITES_CAPACITY 256
+#define SP_LOGGER_SUPPRESSED_MESSAGE "suppressed %lu messages"
+//Minimal time in seconds between two suppressed counts printed for the same call site
+#define SP_LOGGER_SUMMARY_INTERVAL 10.0
+#define SP_LOGGER_SUPPRESSED_MESSAGE_SIZE 64
+
+/*
+ * A structure used for the memory-mapped segments output mode
+ * basename - the name of the active segment file
+ * segmentSize - the size in bytes of every segment file
+ * maxSegments - the number of segment files kept on disk
+ * fd - the file descriptor of the active segment
+ * mapping - the mapped pages of the active segment
+ * used - the number of bytes already written to the active segment
+ */
+typedef struct sp_logger_segment_t {
+	char* basename;
+	size_t segmentSize;
+	int maxSegments;
+	int fd;
+	char* mapping;
+	size_t used;
+} *SPLoggerSegment;
+
+/*
+ * A structure used to track a call site for the rate limit and sampling
+ * A call site is identified by logType, key and line, where key is compared by
+ * pointer: the file (the __FILE__ literal of the caller) of error, warning and debug
+ * records, and the message of info records, which have no call site details.
+ * key - the file of the call site, or the message of info records (NULL if the entry is free)
+ * line - the line of the call site, 0 for info records
+ * logType - the type of the records of the call site
+ * file, function - the call site details used when printing the suppressed count,
+ *                  NULL for info records
+ * tokens - the tokens left in the bucket of the call site
+ * lastRefill - the time in seconds in which the bucket was last refilled
+ * lastSummary - the time in seconds in which the suppressed count was last printed,
+ *               or in which the call site was first seen
+ * seen - the number of records of the call site which passed the level check
+ * suppressed - the number of records dropped since the last printed suppressed count
+ * nextPending - the next call site with a suppressed count to print
+ */
+typedef struct sp_logger_call_site_t {
+	const void* key;
+	int line;
+	SP_LOGGER_LEVEL logType;
+	const char* file;
+	const char* function;
+	double tokens;
+	double lastRefill;
+	double lastSummary;
+	unsigned long seen;
+	unsigned long suppressed;
+	struct sp_logger_call_site_t* nextPending;
+} SPLoggerCallSite;
+
 // Global variable holding the logger
 SPLogger logger = NULL;
 
@@ -22,8 +98,34 @@ struct sp_logger_t {
 	FILE* outputChannel; //The logger file
 	bool isStdOut; //Indicates if the logger is stdout
 	SP_LOGGER_LEVEL level; //Indicates the level
+	SPLoggerSegment segment; //The mapped segments, NULL unless segmented mode is used
+	double recordsPerSecond; //The rate limit of every call site, 0 if not limited
+	double burst; //The token bucket size of every call site
+	int sampleEvery; //The sampling period of every call site, 1 if not sampled
+	SPLoggerCallSite* callSites; //The tracked call sites, NULL if neither limit is used
+	SPLoggerCallSite* firstPending; //The call sites with suppressed counts, in the order of
+	SPLoggerCallSite* lastPending; //their first dropped records
+	SP_LOGGER_TIMESTAMP timestamp; //The clock of the records timestamps
+	clockid_t timestampClock; //The monotonic clock read for every record
+	struct timespec wallClockOffset; //Wall-clock time minus monotonic time
 };
 
+SP_LOGGER_MSG spLoggerFlushSuppressed();
+
+/*
+ * Sets the options of a newly created logger to their defaults
+ * @param newLogger - the logger to initialize
+ */
+void spLoggerInitOptions(SPLogger newLogger) {
+	newLogger->recordsPerSecond = 0;
+	newLogger->burst = 1;
+	newLogger->sampleEvery = 1;
+	newLogger->callSites = NULL;
+	newLogger->firstPending = NULL;
+	newLogger->lastPending = NULL;
+	newLogger->timestamp = SP_LOGGER_TIMESTAMP_NONE;
+}
+
 SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
 	if (logger != NULL) { //Already defined
 		return SP_LOGGER_DEFINED;
@@ -33,6 +135,8 @@ SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
 		return SP_LOGGER_OUT_OF_MEMORY;
 	}
 	logger->level = level; //Set the level of the logger
+	logger->segment = NULL;
+	spLoggerInitOptions(logger);
 	if (filename == NULL) { //In case the filename is not set use stdout
 		logger->outputChannel = stdout;
 		logger->isStdOut = true;
@@ -48,11 +152,279 @@ SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
 	return SP_LOGGER_SUCCESS;
 }
 
+/*
+ * Returns the name of a segment file, the active segment (number 0) is named
+ * basename and older segments are named basename.number
+ * @param basename - the name of the active segment
+ * @param number - the number of the segment (0 is the active one)
+ * @return
+ * NULL in case of memory allocation failure, otherwise a newly allocated name
+ */
+char* spLoggerSegmentName(const char* basename, int number) {
+	char* name = (char*) malloc(strlen(basename) + SP_LOGGER_SEGMENT_NAME_SUFFIX_SIZE);
+	if (name == NULL)
+		return NULL;
+	if (number == 0)
+		strcpy(name, basename);
+	else
+		sprintf(name, SP_LOGGER_SEGMENT_NAME_FORMAT, basename, number);
+	return name;
+}
+
+/*
+ * Shifts the segment files by one - the oldest kept segment is overwritten and
+ * the active segment file becomes basename.1
+ * Missing segment files are skipped.
+ * @param segment - the segments to rotate
+ * @return
+ * false in case of memory allocation failure, true otherwise
+ */
+bool spLoggerSegmentRotate(SPLoggerSegment segment) {
+	int number;
+	char *olderName, *newerName;
+
+	for (number = segment->maxSegments - 1; number > 0; number--) {
+		olderName = spLoggerSegmentName(segment->basename, number);
+		newerName = spLoggerSegmentName(segment->basename, number - 1);
+		if (olderName == NULL || newerName == NULL) {
+			free(olderName);
+			free(newerName);
+			return false;
+		}
+		rename(newerName, olderName); //fails harmlessly if newerName is missing
+		free(olderName);
+		free(newerName);
+	}
+	return true;
+}
+
+/*
+ * Rotates the segment files and creates, preallocates and maps a new active segment.
+ * On failure the segment has no active segment (fd is -1 and mapping is NULL).
+ * @param segment - the segments to open a new active segment in
+ * @return
+ * SP_LOGGER_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_LOGGER_CANNOT_OPEN_FILE - if the segment cannot be created, allocated on disk or mapped
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerSegmentOpen(SPLoggerSegment segment) {
+	void* mapping;
+
+	segment->fd = -1;
+	segment->mapping = NULL;
+	if (!spLoggerSegmentRotate(segment))
+		return SP_LOGGER_OUT_OF_MEMORY;
+
+	segment->fd = open(segment->basename, O_RDWR | O_CREAT | O_TRUNC, SP_LOGGER_SEGMENT_MODE);
+	if (segment->fd < 0) {
+		segment->fd = -1;
+		return SP_LOGGER_CANNOT_OPEN_FILE;
+	}
+
+	//the blocks are allocated now, a sparse file would raise SIGBUS on a full disk
+	if (posix_fallocate(segment->fd, 0, (off_t) segment->segmentSize) != 0) {
+		close(segment->fd);
+		segment->fd = -1;
+		return SP_LOGGER_CANNOT_OPEN_FILE;
+	}
+
+	mapping = mmap(NULL, segment->segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+	if (mapping == MAP_FAILED) {
+		close(segment->fd);
+		segment->fd = -1;
+		return SP_LOGGER_CANNOT_OPEN_FILE;
+	}
+
+	segment->mapping = (char*) mapping;
+	segment->used = 0;
+	return SP_LOGGER_SUCCESS;
+}
+
+/*
+ * Unmaps and closes the active segment, the file is truncated to the written size.
+ * Nothing is done for the parts of a segment which failed to open.
+ * @param segment - the segments to close the active segment of
+ * @return
+ * SP_LOGGER_WRITE_FAIL - if the file could not be truncated, it keeps its unwritten
+ *                        preallocated bytes (zeros) after the records
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerSegmentClose(SPLoggerSegment segment) {
+	SP_LOGGER_MSG retVal = SP_LOGGER_SUCCESS;
+
+	if (segment->mapping != NULL) {
+		munmap(segment->mapping, segment->segmentSize);
+		segment->mapping = NULL;
+	}
+	if (segment->fd < 0)
+		return SP_LOGGER_SUCCESS;
+	if (ftruncate(segment->fd, (off_t) segment->used) != 0)
+		retVal = SP_LOGGER_WRITE_FAIL;
+	close(segment->fd);
+	segment->fd = -1;
+	return retVal;
+}
+
+/*
+ * Closes the active segment and opens a new one
+ * @param segment - the segments to rotate
+ * @return
+ * SP_LOGGER_WRITE_FAIL - if the active segment could not be truncated or a new
+ *                        segment could not be opened
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerSegmentNext(SPLoggerSegment segment) {
+	SP_LOGGER_MSG closed = spLoggerSegmentClose(segment);
+
+	if (spLoggerSegmentOpen(segment) != SP_LOGGER_SUCCESS)
+		return SP_LOGGER_WRITE_FAIL;
+	return closed;
+}
+
+/*
+ * Copies a record into the mapped pages. A record which does not fit the space
+ * left in the active segment is written to a new segment, so segments hold whole
+ * records. Only a record longer than a whole segment is split, over as many
+ * segments as it needs.
+ * @param segment - the segments to write to
+ * @param data - the bytes to write
+ * @param length - the number of bytes to write
+ * @return
+ * SP_LOGGER_WRITE_FAIL - if a new segment could not be opened (the rest of the record
+ *                        is lost), or a full segment could not be truncated
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerSegmentWrite(SPLoggerSegment segment, const char* data, size_t length) {
+	SP_LOGGER_MSG retVal = SP_LOGGER_SUCCESS;
+	size_t chunk;
+
+	//a segment which failed to open is opened again
+	if (segment->mapping == NULL && spLoggerSegmentOpen(segment) != SP_LOGGER_SUCCESS)
+		return SP_LOGGER_WRITE_FAIL;
+	if (segment->used > 0 && length <= segment->segmentSize
+			&& length > segment->segmentSize - segment->used)
+		retVal = spLoggerSegmentNext(segment);
+	while (length > 0 && segment->mapping != NULL) {
+		if (segment->used == segment->segmentSize && spLoggerSegmentNext(segment) != SP_LOGGER_SUCCESS) {
+			retVal = SP_LOGGER_WRITE_FAIL;
+			continue;
+		}
+		chunk = segment->segmentSize - segment->used;
+		if (chunk > length)
+			chunk = length;
+		memcpy(segment->mapping + segment->used, data, chunk);
+		segment->used += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+	return segment->mapping == NULL ? SP_LOGGER_WRITE_FAIL : retVal;
+}
+
+/*
+ * Formats a record followed by a new line and copies it to the active segment.
+ * Records which fit SP_LOGGER_RECORD_BUFFER_SIZE are formatted on the stack.
+ * @param segment - the segments to write to
+ * @param format - the format of the record
+ * @param args - the format arguments
+ * @return
+ * SP_LOGGER_WRITE_FAIL - if formatting or writing failed
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerSegmentPrint(SPLoggerSegment segment, const char* format, va_list args) {
+	char buffer[SP_LOGGER_RECORD_BUFFER_SIZE];
+	char* record = buffer;
+	int length;
+	va_list argsCopy;
+	SP_LOGGER_MSG retVal;
+
+	va_copy(argsCopy, args);
+	length = vsnprintf(buffer, SP_LOGGER_RECORD_BUFFER_SIZE, format, args);
+	if (length >= SP_LOGGER_RECORD_BUFFER_SIZE) { //too long for the stack buffer
+		record = (char*) malloc((size_t) length + 1);
+		if (record == NULL)
+			length = -1;
+		else
+			length = vsnprintf(record, (size_t) length + 1, format, argsCopy);
+	}
+	va_end(argsCopy);
+
+	if (length < 0) {
+		if (record != buffer)
+			free(record);
+		return SP_LOGGER_WRITE_FAIL;
+	}
+
+	record[length] = '\n'; //replaces the terminating null
+	retVal = spLoggerSegmentWrite(segment, record, (size_t) length + 1);
+	if (record != buffer)
+		free(record);
+	return retVal;
+}
+
+/*
+ * Frees all resources of the segments, closing the active segment
+ * @param segment - the segments to free, if NULL nothing happens
+ */
+void spLoggerSegmentDestroy(SPLoggerSegment segment) {
+	if (segment == NULL)
+		return;
+	//a failed truncate leaves zeros after the records, and there is no caller to report it to
+	spLoggerSegmentClose(segment);
+	free(segment->basename);
+	free(segment);
+}
+
+SP_LOGGER_MSG spLoggerCreateSegmented(const char* basename, SP_LOGGER_LEVEL level,
+		int segmentSize, int maxSegments) {
+	SPLoggerSegment segment;
+	SP_LOGGER_MSG retVal;
+
+	if (logger != NULL) //Already defined
+		return SP_LOGGER_DEFINED;
+	if (basename == NULL || segmentSize <= 0 || maxSegments <= 0)
+		return SP_LOGGER_INVAlID_ARGUMENT;
+
+	segment = (SPLoggerSegment) calloc(1, sizeof(*segment));
+	if (segment == NULL)
+		return SP_LOGGER_OUT_OF_MEMORY;
+	segment->basename = (char*) malloc(strlen(basename) + 1);
+	if (segment->basename == NULL) {
+		free(segment);
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	strcpy(segment->basename, basename);
+	segment->segmentSize = (size_t) segmentSize;
+	segment->maxSegments = maxSegments;
+	segment->fd = -1;
+
+	retVal = spLoggerSegmentOpen(segment);
+	if (retVal != SP_LOGGER_SUCCESS) {
+		spLoggerSegmentDestroy(segment);
+		return retVal;
+	}
+
+	logger = (SPLogger) malloc(sizeof(*logger));
+	if (logger == NULL) { //Allocation failure
+		spLoggerSegmentDestroy(segment);
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	logger->level = level;
+	logger->outputChannel = NULL;
+	logger->isStdOut = false;
+	logger->segment = segment;
+	spLoggerInitOptions(logger);
+	return SP_LOGGER_SUCCESS;
+}
+
 void spLoggerDestroy() {
 	if (!logger) {
 		return;
 	}
-	if (!logger->isStdOut) {//Close file only if not stdout
+	spLoggerFlushSuppressed(); //the remaining counts, a failure has no caller to reach
+	free(logger->callSites);
+	if (logger->segment != NULL) {//Segmented mode, unmap the active segment
+		spLoggerSegmentDestroy(logger->segment);
+	} else if (!logger->isStdOut) {//Close file only if not stdout
 		fclose(logger->outputChannel);
 	}
 	free(logger);//free allocation
@@ -73,12 +445,20 @@ void spLoggerDestroy() {
  */
 SP_LOGGER_MSG spLoggerPrintFormmatedString(const char* msg, ...) {
     va_list args;
+	SP_LOGGER_MSG retVal;
 
 	if (logger == NULL)
 		return SP_LOGGER_UNDIFINED;
 	if (msg == NULL)
 		return SP_LOGGER_INVAlID_ARGUMENT;
 
+	if (logger->segment != NULL) { //Segmented mode, format once and copy to the mapping
+		va_start(args, msg);
+		retVal = spLoggerSegmentPrint(logger->segment, msg, args);
+		va_end(args);
+		return retVal;
+	}
+
     va_start(args, msg);
 
 	if (vfprintf(logger->outputChannel, msg, args) < 0)
@@ -127,6 +507,303 @@ bool verifyWritePrivileges(enum sp_logger_level_t logType) {
 }
 
 
+/*
+ * Returns the current time in seconds from a monotonic clock
+ */
+double spLoggerMonotonicSeconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+SP_LOGGER_MSG spLoggerSetTimestamps(SP_LOGGER_TIMESTAMP timestamp) {
+	struct timespec wallClock, monotonic;
+
+	if (logger == NULL)
+		return SP_LOGGER_UNDIFINED;
+
+	switch (timestamp) {
+		case SP_LOGGER_TIMESTAMP_NONE:
+			logger->timestamp = timestamp;
+			return SP_LOGGER_SUCCESS;
+		case SP_LOGGER_TIMESTAMP_COARSE:
+#ifdef CLOCK_MONOTONIC_COARSE
+			logger->timestampClock = CLOCK_MONOTONIC_COARSE;
+#else
+			logger->timestampClock = CLOCK_MONOTONIC;
+#endif
+			break;
+		case SP_LOGGER_TIMESTAMP_PRECISE:
+			logger->timestampClock = CLOCK_MONOTONIC;
+			break;
+		default:
+			return SP_LOGGER_INVAlID_ARGUMENT;
+	}
+
+	// the offset between the clocks is computed once, records only read the monotonic clock
+	clock_gettime(CLOCK_REALTIME, &wallClock);
+	clock_gettime(logger->timestampClock, &monotonic);
+	logger->wallClockOffset.tv_sec = wallClock.tv_sec - monotonic.tv_sec;
+	logger->wallClockOffset.tv_nsec = wallClock.tv_nsec - monotonic.tv_nsec;
+	if (logger->wallClockOffset.tv_nsec < 0) {
+		logger->wallClockOffset.tv_sec--;
+		logger->wallClockOffset.tv_nsec += NANOSECONDS_IN_SECOND;
+	}
+	logger->timestamp = timestamp;
+	return SP_LOGGER_SUCCESS;
+}
+
+/*
+ * Returns the wall-clock time of a record, using the monotonic clock and the offset
+ * assumption - logger is not null and logger->timestamp is not SP_LOGGER_TIMESTAMP_NONE
+ */
+struct timespec spLoggerRecordTime() {
+	struct timespec now;
+	clock_gettime(logger->timestampClock, &now);
+	now.tv_sec += logger->wallClockOffset.tv_sec;
+	now.tv_nsec += logger->wallClockOffset.tv_nsec;
+	if (now.tv_nsec >= NANOSECONDS_IN_SECOND) {
+		now.tv_sec++;
+		now.tv_nsec -= NANOSECONDS_IN_SECOND;
+	}
+	return now;
+}
+
+/*
+ * Prints a record with the file, function and line details, and a timestamp if set
+ * assumption - logger is not null, all arguments are valid
+ */
+SP_LOGGER_MSG spLoggerPrintGeneralRecord(enum sp_logger_level_t logType, const char* msg,
+		const char* file, const char* function, const int line) {
+	struct timespec recordTime;
+
+	if (logger->timestamp == SP_LOGGER_TIMESTAMP_NONE)
+		return spLoggerPrintFormmatedString(GENERAL_MESSAGE_SKELETON,
+				getLoggerNameFromType(logType), file, function, line, msg);
+
+	recordTime = spLoggerRecordTime();
+	return spLoggerPrintFormmatedString(TIMED_GENERAL_MESSAGE_SKELETON,
+			getLoggerNameFromType(logType), (long long) recordTime.tv_sec, (long) recordTime.tv_nsec,
+			file, function, line, msg);
+}
+
+/*
+ * Prints a record with the message only, and a timestamp if set
+ * assumption - logger is not null, all arguments are valid
+ */
+SP_LOGGER_MSG spLoggerPrintShortRecord(enum sp_logger_level_t logType, const char* msg) {
+	struct timespec recordTime;
+
+	if (logger->timestamp == SP_LOGGER_TIMESTAMP_NONE)
+		return spLoggerPrintFormmatedString(SHORT_MESSAGE_SKELETON,
+				getLoggerNameFromType(logType), msg);
+
+	recordTime = spLoggerRecordTime();
+	return spLoggerPrintFormmatedString(TIMED_SHORT_MESSAGE_SKELETON,
+			getLoggerNameFromType(logType), (long long) recordTime.tv_sec, (long) recordTime.tv_nsec, msg);
+}
+
+/*
+ * Prints the remaining suppressed counts, then allocates the call sites table if
+ * the rate limit or sampling is used, and frees it if neither is used any more
+ * assumption - logger is not null
+ * @return
+ * SP_LOGGER_OUT_OF_MEMORY - in case of memory allocation failure
+ * SP_LOGGER_WRITE_FAIL - if a suppressed count could not be printed
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerUpdateCallSites() {
+	SP_LOGGER_MSG retVal = spLoggerFlushSuppressed();
+
+	if (logger->recordsPerSecond == 0 && logger->sampleEvery == 1) {
+		free(logger->callSites);
+		logger->callSites = NULL;
+	} else if (logger->callSites == NULL) {
+		logger->callSites = (SPLoggerCallSite*) calloc(SP_LOGGER_CALL_SITES_CAPACITY,
+				sizeof(SPLoggerCallSite));
+		if (logger->callSites == NULL)
+			return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	return retVal;
+}
+
+SP_LOGGER_MSG spLoggerSetRateLimit(double recordsPerSecond, int burst) {
+	if (logger == NULL)
+		return SP_LOGGER_UNDIFINED;
+	if (recordsPerSecond < 0 || burst < 1)
+		return SP_LOGGER_INVAlID_ARGUMENT;
+	logger->recordsPerSecond = recordsPerSecond;
+	logger->burst = burst;
+	return spLoggerUpdateCallSites();
+}
+
+SP_LOGGER_MSG spLoggerSetSampling(int sampleEvery) {
+	if (logger == NULL)
+		return SP_LOGGER_UNDIFINED;
+	if (sampleEvery < 1)
+		return SP_LOGGER_INVAlID_ARGUMENT;
+	logger->sampleEvery = sampleEvery;
+	return spLoggerUpdateCallSites();
+}
+
+/*
+ * Finds the entry of a call site in the call sites table, claiming a free entry
+ * for a call site seen for the first time
+ * assumption - logger and logger->callSites are not null
+ * @return
+ * NULL if the call site is new and the table is full, otherwise the entry
+ */
+SPLoggerCallSite* spLoggerFindCallSite(enum sp_logger_level_t logType, const void* key,
+		const char* file, const char* function, int line) {
+	int probe;
+	SPLoggerCallSite* site;
+	uintptr_t hash = ((uintptr_t) key >> 3) ^ ((uintptr_t) line * 2654435761u)
+			^ (uintptr_t) logType;
+
+	for (probe = 0; probe < SP_LOGGER_CALL_SITES_CAPACITY; probe++) {
+		site = &logger->callSites[(hash + probe) & (SP_LOGGER_CALL_SITES_CAPACITY - 1)];
+		if (site->key == key && site->line == line && site->logType == logType)
+			return site;
+		if (site->key == NULL) { //first record of this call site
+			site->key = key;
+			site->line = line;
+			site->logType = logType;
+			site->file = file;
+			site->function = function;
+			site->tokens = logger->burst;
+			site->lastRefill = spLoggerMonotonicSeconds();
+			site->lastSummary = site->lastRefill;
+			return site;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Counts a record dropped at a call site, a call site without a count yet is
+ * queued to have its count printed
+ * assumption - logger is not null
+ */
+void spLoggerSuppress(SPLoggerCallSite* site) {
+	if (site->suppressed++ > 0)
+		return;
+	site->nextPending = NULL;
+	if (logger->lastPending == NULL)
+		logger->firstPending = site;
+	else
+		logger->lastPending->nextPending = site;
+	logger->lastPending = site;
+}
+
+/*
+ * Prints the number of records dropped at a call site, and resets the count
+ * assumption - logger is not null, site->suppressed > 0
+ */
+SP_LOGGER_MSG spLoggerPrintSuppressed(SPLoggerCallSite* site) {
+	char message[SP_LOGGER_SUPPRESSED_MESSAGE_SIZE];
+
+	sprintf(message, SP_LOGGER_SUPPRESSED_MESSAGE, site->suppressed);
+	site->suppressed = 0;
+	if (site->file == NULL)
+		return spLoggerPrintShortRecord(site->logType, message);
+	return spLoggerPrintGeneralRecord(site->logType, message, site->file,
+			site->function, site->line);
+}
+
+/*
+ * Prints the suppressed counts of the queued call sites, in the order in which their
+ * first records were dropped. If due is true, only the counts of call sites whose
+ * last count was printed at least SP_LOGGER_SUMMARY_INTERVAL seconds ago are printed,
+ * and the other call sites stay queued.
+ * @param due - true to print only the counts which are due, false to print all of them
+ * @return
+ * SP_LOGGER_WRITE_FAIL - if a count could not be printed, the other counts are still printed
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerPrintPendingSuppressed(bool due) {
+	SPLoggerCallSite* site;
+	SPLoggerCallSite* next;
+	SPLoggerCallSite* kept = NULL;
+	SP_LOGGER_MSG retVal = SP_LOGGER_SUCCESS;
+	double now = due ? spLoggerMonotonicSeconds() : 0;
+
+	site = logger->firstPending;
+	logger->firstPending = NULL;
+	logger->lastPending = NULL;
+	for (; site != NULL; site = next) {
+		next = site->nextPending;
+		if (due && now - site->lastSummary < SP_LOGGER_SUMMARY_INTERVAL) { //keep it queued
+			site->nextPending = NULL;
+			if (kept == NULL)
+				logger->firstPending = site;
+			else
+				kept->nextPending = site;
+			kept = site;
+			logger->lastPending = site;
+			continue;
+		}
+		site->lastSummary = now;
+		if (spLoggerPrintSuppressed(site) != SP_LOGGER_SUCCESS)
+			retVal = SP_LOGGER_WRITE_FAIL;
+	}
+	return retVal;
+}
+
+/*
+ * Prints the remaining suppressed counts of all call sites
+ * @return
+ * SP_LOGGER_WRITE_FAIL - if a count could not be printed
+ * SP_LOGGER_SUCCESS - otherwise
+ */
+SP_LOGGER_MSG spLoggerFlushSuppressed() {
+	if (logger == NULL || logger->firstPending == NULL)
+		return SP_LOGGER_SUCCESS;
+	return spLoggerPrintPendingSuppressed(false);
+}
+
+/*
+ * Applies the sampling and the rate limit to a record of a given call site.
+ * Before an admitted record, the suppressed counts of the call sites whose last
+ * count was printed at least SP_LOGGER_SUMMARY_INTERVAL seconds ago are printed.
+ * assumption - logger and logger->callSites are not null
+ * @param logType - the type of the record
+ * @param key - the file of the call site, or the message of info records
+ * @param file, function, line - the call site details, NULL, NULL and 0 for info records
+ * @param retVal - set to the result of printing the suppressed counts
+ * @return
+ * true iff the record should be printed
+ */
+bool spLoggerAdmit(enum sp_logger_level_t logType, const void* key,
+		const char* file, const char* function, int line, SP_LOGGER_MSG* retVal) {
+	double now;
+	SPLoggerCallSite* site = spLoggerFindCallSite(logType, key, file, function, line);
+
+	*retVal = SP_LOGGER_SUCCESS;
+	if (site != NULL) { //records of new call sites are not limited when the table is full
+		if (site->seen++ % (unsigned long) logger->sampleEvery != 0) {
+			spLoggerSuppress(site);
+			return false;
+		}
+
+		if (logger->recordsPerSecond > 0) {
+			now = spLoggerMonotonicSeconds();
+			site->tokens += (now - site->lastRefill) * logger->recordsPerSecond;
+			if (site->tokens > logger->burst)
+				site->tokens = logger->burst;
+			site->lastRefill = now;
+			if (site->tokens < 1) {
+				spLoggerSuppress(site);
+				return false;
+			}
+			site->tokens -= 1;
+		}
+	}
+
+	if (logger->firstPending != NULL)
+		*retVal = spLoggerPrintPendingSuppressed(true);
+	return true;
+}
+
 /**
  * 	Prints general message by type. as the following format:
  * 	---TYPE---
@@ -163,6 +840,8 @@ bool verifyWritePrivileges(enum sp_logger_level_t logType) {
  */
 SP_LOGGER_MSG spLoggerPrint(enum sp_logger_level_t logType, const char* msg,
 		const char* file, const char* function, const int line) {
+	SP_LOGGER_MSG retVal = SP_LOGGER_SUCCESS, printed;
+
 	if (logger == NULL)
 		return SP_LOGGER_UNDIFINED;
 
@@ -172,8 +851,13 @@ SP_LOGGER_MSG spLoggerPrint(enum sp_logger_level_t logType, const char* msg,
 	if (!verifyWritePrivileges(logType))
 		return SP_LOGGER_SUCCESS;
 
-	return spLoggerPrintFormmatedString(GENERAL_MESSAGE_SKELETON,
-			getLoggerNameFromType(logType), file,function,line,msg);
+	if (logger->callSites != NULL) {
+		if (!spLoggerAdmit(logType, file, file, function, line, &retVal))
+			return SP_LOGGER_SUCCESS;
+	}
+
+	printed = spLoggerPrintGeneralRecord(logType, msg, file, function, line);
+	return retVal != SP_LOGGER_SUCCESS ? retVal : printed;
 }
 
 SP_LOGGER_MSG spLoggerPrintError(const char* msg, const char* file,
@@ -188,6 +872,8 @@ SP_LOGGER_MSG spLoggerPrintWarning(const char* msg, const char* file,
 }
 
 SP_LOGGER_MSG spLoggerPrintInfo(const char* msg) {
+	SP_LOGGER_MSG retVal = SP_LOGGER_SUCCESS, printed;
+
 	if (logger == NULL)
 		return SP_LOGGER_UNDIFINED;
 
@@ -197,7 +883,13 @@ SP_LOGGER_MSG spLoggerPrintInfo(const char* msg) {
 	if (!verifyWritePrivileges(SP_LOGGER_INFO_WARNING_ERROR_LEVEL))
 		return SP_LOGGER_SUCCESS;
 
-	return spLoggerPrintFormmatedString(SHORT_MESSAGE_SKELETON,INFO_MSG,msg);
+	if (logger->callSites != NULL) {
+		if (!spLoggerAdmit(SP_LOGGER_INFO_WARNING_ERROR_LEVEL, msg, NULL, NULL, 0, &retVal))
+			return SP_LOGGER_SUCCESS;
+	}
+
+	printed = spLoggerPrintShortRecord(SP_LOGGER_INFO_WARNING_ERROR_LEVEL, msg);
+	return retVal != SP_LOGGER_SUCCESS ? retVal : printed;
 }
 
 SP_LOGGER_MSG spLoggerPrintDebug(const char* msg, const char* file,
@@ -16,12 +16,16 @@
  *	
  * The following functions are supported:
  * spLoggerCreate 		- Creates and initializes the logger
+ * spLoggerCreateSegmented - Creates the logger over rotating memory-mapped segment files
  * spLoggerDestroy		- Closes are frees all resources of the logger
  * spLoggerPrintError   - Prints error messages at leves {Error, Warning, Info, Debug}
  * spLoggerPrintWarning - Prints warnning messages at levels {Warning, Info, Debug}
  * spLoggerPrintInfo    - Prints info messages at levels {Info, Debug}
  * spLoggerPrintDebug   - Prints debug messages at level {Debug}
  * spLoggerPrintMsg     - Prints the exact message at any level (Without formatting)
+ * spLoggerSetRateLimit - Limits the rate of records printed from every call site
+ * spLoggerSetSampling  - Prints only one of every N records of every call site
+ * spLoggerSetTimestamps - Adds a timestamp to every error, warning, info and debug record
  */
 
 /** A type used to decide the level of the logger**/
@@ -32,6 +36,13 @@ typedef enum sp_logger_level_t {
 	SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL //Debug level
 } SP_LOGGER_LEVEL;
 
+/** A type used to select the clock of the records timestamps **/
+typedef enum sp_logger_timestamp_t {
+	SP_LOGGER_TIMESTAMP_NONE, //Records carry no timestamp
+	SP_LOGGER_TIMESTAMP_COARSE, //Cheapest monotonic clock, a resolution of a few milliseconds
+	SP_LOGGER_TIMESTAMP_PRECISE //Monotonic clock with a nanoseconds resolution
+} SP_LOGGER_TIMESTAMP;
+
 /** A type used to indicate errors in function calls **/
 typedef enum sp_logger_msg_t {
 	SP_LOGGER_CANNOT_OPEN_FILE,
@@ -63,6 +74,42 @@ typedef struct sp_logger_t* SPLogger;
  */
 SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level);
 
+/**
+ * Creates a logger which writes into preallocated, memory-mapped segment files
+ * of a fixed size instead of a stdio stream. Every record is formatted once and
+ * copied into the mapped pages of the active segment, whose blocks are allocated
+ * on disk when it is opened. When a record does not fit the space left in the
+ * active segment, the segment is closed and the segments are rotated, so every
+ * segment holds whole records (only a record longer than segmentSize is split
+ * over several segments), and at most maxSegments files exist at any time:
+ *
+ * 	<basename>     - the active segment
+ * 	<basename>.1   - the previous segment
+ * 	...
+ * 	<basename>.<maxSegments - 1> - the oldest segment kept
+ *
+ * An existing <basename> left by a previous run is rotated (and not truncated)
+ * when the logger is created, unless maxSegments is 1: a single segment keeps no
+ * older segments, so the file of the previous run is truncated and every full
+ * segment is overwritten by the next one. When the logger is destroyed the active
+ * segment is truncated to the number of bytes actually written.
+ * Like spLoggerCreate, this function should be called once prior to the usage
+ * of any SP Logger print functions.
+ *
+ * @param basename - The name of the active segment file
+ * @param level - The level of the logger prints
+ * @param segmentSize - The size in bytes of every segment file (segmentSize > 0)
+ * @param maxSegments - The number of segment files kept (maxSegments > 0)
+ * @return
+ * SP_LOGGER_DEFINED 			- The logger has been defined
+ * SP_LOGGER_INVAlID_ARGUMENT	- If basename is NULL or segmentSize <= 0 or maxSegments <= 0
+ * SP_LOGGER_OUT_OF_MEMORY 		- In case of memory allocation failure
+ * SP_LOGGER_CANNOT_OPEN_FILE 	- If a segment file cannot be created, allocated on disk or mapped
+ * SP_LOGGER_SUCCESS 			- In case the logger has been successfully opened
+ */
+SP_LOGGER_MSG spLoggerCreateSegmented(const char* basename, SP_LOGGER_LEVEL level,
+		int segmentSize, int maxSegments);
+
 /**
  * Frees all memory allocated for the logger. If the logger is not defined
  * then nothing happens.
@@ -214,4 +261,66 @@ SP_LOGGER_MSG spLoggerPrintDebug(const char* msg, const char* file,
  */
 SP_LOGGER_MSG spLoggerPrintMsg(const char* msg);
 
+/**
+ * Limits the number of records printed from every call site using a token bucket.
+ * Every call site holds up to burst tokens, refilled at recordsPerSecond tokens
+ * per second, and a record is printed only if a token is available.
+ * A call site of error, warning and debug records is identified by its type, file
+ * and line, where file is compared by pointer (as given by __FILE__). Info records
+ * have no call site details, and are identified by their msg pointer, so messages
+ * formatted into the same buffer are limited as one call site.
+ * Records dropped by the limit are counted per call site, and a record of the call
+ * site whose message is:
+ * 	suppressed <count> messages
+ * is printed at most once every 10 seconds per call site, before the next printed
+ * record of any call site. Remaining counts are printed when the limit or the
+ * sampling is set again and when the logger is destroyed.
+ * spLoggerPrintMsg is never limited.
+ *
+ * @param recordsPerSecond - The refill rate of every call site, 0 disables the limit
+ * @param burst - The maximal number of tokens of every call site (burst >= 1)
+ * @return
+ * SP_LOGGER_UNDIFINED 			- If the logger is undefined
+ * SP_LOGGER_INVAlID_ARGUMENT	- If recordsPerSecond < 0 or burst < 1
+ * SP_LOGGER_OUT_OF_MEMORY		- In case of memory allocation failure
+ * SP_LOGGER_WRITE_FAIL			- If a remaining suppressed count could not be printed
+ * SP_LOGGER_SUCCESS			- otherwise
+ */
+SP_LOGGER_MSG spLoggerSetRateLimit(double recordsPerSecond, int burst);
+
+/**
+ * Prints only the first of every sampleEvery records of every call site
+ * (call sites are identified as in spLoggerSetRateLimit). Sampled out records
+ * are counted and reported the same way as records dropped by the rate limit.
+ * Sampling is applied before the rate limit.
+ *
+ * @param sampleEvery - The sampling period, 1 disables sampling
+ * @return
+ * SP_LOGGER_UNDIFINED 			- If the logger is undefined
+ * SP_LOGGER_INVAlID_ARGUMENT	- If sampleEvery < 1
+ * SP_LOGGER_OUT_OF_MEMORY		- In case of memory allocation failure
+ * SP_LOGGER_WRITE_FAIL			- If a remaining suppressed count could not be printed
+ * SP_LOGGER_SUCCESS			- otherwise
+ */
+SP_LOGGER_MSG spLoggerSetSampling(int sampleEvery);
+
+/**
+ * Sets the timestamp added to error, warning, info and debug records. When a
+ * timestamp is used, a line is printed right after the record type line:
+ * 	- time: <seconds>.<nanoseconds>
+ * where the time is the wall-clock time since the epoch.
+ * Every record only reads the selected monotonic clock, the monotonic time is
+ * converted to wall-clock time by an offset which is computed once, when the
+ * timestamps are set. Therefore the timestamps do not follow later adjustments
+ * of the system clock.
+ * Messages printed by spLoggerPrintMsg never carry a timestamp.
+ *
+ * @param timestamp - The clock used for the timestamps, or SP_LOGGER_TIMESTAMP_NONE
+ * @return
+ * SP_LOGGER_UNDIFINED 			- If the logger is undefined
+ * SP_LOGGER_INVAlID_ARGUMENT	- If timestamp is not one of SP_LOGGER_TIMESTAMP values
+ * SP_LOGGER_SUCCESS			- otherwise
+ */
+SP_LOGGER_MSG spLoggerSetTimestamps(SP_LOGGER_TIMESTAMP timestamp);
+
 #endif
@@ -1,46 +1,72 @@
-#include "SPPoint.h"
+#define _POSIX_C_SOURCE 200112L
+#include "SPPointInternal.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 /*
- * A structure used for the point data type
- * data - an array of the axis data of the point
- * dim - an integer representing the dimension of the point
- * index -  an integer representing the image index related to the point
+ * allocates a point of the given dimension and index as one block, with storageSize
+ * bytes of storage
+ * @dim - the dimension of the point
+ * @index - the index of the point
+ * @storageSize - the size in bytes of the storage of the point
+ *
+ * @returns
+ * NULL in case of allocation failure, otherwise the new point, with
+ * data pointing to its uninitialized storage
  */
-struct sp_point_t {
-	double* data;
-	int dim;
-	int index;
-};
+SPPoint spPointAllocate(int dim, int index, size_t storageSize) {
+	SPPoint item;
+
+	// malloc rather than posix_memalign, which misses the thread cache of glibc
+	item = (SPPoint) malloc(sizeof(struct sp_point_t) + storageSize);
+	if (item == NULL)
+		return NULL; //allocation error
+
+	item->data = item->storage;
+	item->dim = dim;
+	item->index = index;
+
+	return item;
+}
 
 /*
- * creates a new double array with the same values of the given array
- * @data - the source array to be copied
- * @size - the size of the array
+ * creates a point which does not hold its coordinates array
+ * @data - the coordinates array of the point
+ * @dim - the dimension of the point
+ * @index - the index of the point
+ * @kind - SP_POINT_OWNED if the point adopts data, SP_POINT_VIEW if it borrows it
+ * @destructor, @context - the callback releasing an adopted data and its context
  *
  * @returns
- * NULL if data is NULL or size < 0, otherwise a hard copy of the given array
+ * NULL in case of allocation failure or invalid arguments, otherwise the new point
  */
-double* copyData(double* data, int size) {
-	int i;
-	double* newData;
+SPPoint spPointCreateExternal(double* data, int dim, int index, SP_POINT_OWNER_KIND kind,
+		SPPointDataDestructor destructor, void* context) {
+	SPPoint item;
+	SPPointOwner* owner;
 
-	if (data == NULL || size < 0)
+	if (data == NULL || dim <= 0 || index < 0) //illegal arguments
 		return NULL;
 
-	newData = (double*)calloc(size, sizeof(double));
-
-	if (newData == NULL)
+	item = spPointAllocate(dim, index, sizeof(SPPointOwner));
+	if (item == NULL) // allocation error
 		return NULL;
 
-	for (i = 0; i < size; i++)
-		newData[i] = data[i];
+	owner = spPointGetOwner(item);
+	owner->kind = kind;
+	owner->destructor = destructor;
+	owner->context = context;
+	item->data = data;
+	if (kind != SP_POINT_VIEW)
+		item->squaredNorm = spDistanceSquaredNorm(data, dim);
 
-	return newData;
+	return item;
 }
 
 SPPoint spPointCreate(double* data, int dim, int index) {
+	SPPoint item;
+
 	if (data == NULL) //data is null
 		return NULL;
 
@@ -50,65 +76,181 @@ SPPoint spPointCreate(double* data, int dim, int index) {
 	if (index < 0) //index illegal
 		return NULL;
 
-	SPPoint item = (SPPoint)calloc(1,sizeof(struct sp_point_t));
+	item = spPointAllocate(dim, index, sizeof(double) * (size_t) dim);
 	if (item == NULL) // allocation error
 		return NULL;
 
-	item->data = copyData(data,dim);
-	if (item->data == NULL)
-		return NULL; //allocation error
-
-	item->dim = dim;
-	item->index = index;
+	memcpy(item->data, data, sizeof(double) * (size_t) dim);
+	item->squaredNorm = spDistanceSquaredNorm(item->data, dim);
 
 	return item;
 }
 
+SPPoint spPointCreateOwned(double* data, int dim, int index,
+		SPPointDataDestructor destructor, void* context) {
+	return spPointCreateExternal(data, dim, index, SP_POINT_OWNED, destructor, context);
+}
+
+SPPoint spPointCreateView(double* data, int dim, int index) {
+	return spPointCreateExternal(data, dim, index, SP_POINT_VIEW, NULL, NULL);
+}
+
+bool spPointCreateBatch(const double* matrix, int n, int dim, const int* indices, SPPoint* out) {
+	size_t pointSize, coordinatesOffset;
+	void* allocated;
+	char* block;
+	SPPoint item;
+	SPPointOwner* owner;
+	int i;
+
+	if (matrix == NULL || out == NULL || n <= 0 || dim <= 0) //illegal arguments
+		return false;
+	for (i = 0; indices != NULL && i < n; i++) {
+		if (indices[i] < 0) //index illegal
+			return false;
+	}
+
+	// the point headers are followed by the coordinates, which start at an aligned offset
+	pointSize = sizeof(struct sp_point_t) + sizeof(SPPointOwner);
+	coordinatesOffset = (pointSize * (size_t) n + SP_POINT_ALIGNMENT - 1)
+			/ SP_POINT_ALIGNMENT * SP_POINT_ALIGNMENT;
+	if (posix_memalign(&allocated, SP_POINT_ALIGNMENT,
+			coordinatesOffset + sizeof(double) * (size_t) n * (size_t) dim) != 0)
+		return false; //allocation error
+	block = (char*) allocated;
+
+	memcpy(block + coordinatesOffset, matrix, sizeof(double) * (size_t) n * (size_t) dim);
+
+	for (i = 0; i < n; i++) {
+		item = (SPPoint) (block + pointSize * (size_t) i);
+		item->data = (double*) (block + coordinatesOffset) + (size_t) i * (size_t) dim;
+		item->dim = dim;
+		item->index = indices == NULL ? i : indices[i];
+		item->squaredNorm = spDistanceSquaredNorm(item->data, dim);
+		owner = spPointGetOwner(item);
+		owner->kind = SP_POINT_BATCH;
+		owner->destructor = NULL;
+		owner->context = block;
+		out[i] = item;
+	}
+
+	return true;
+}
+
 SPPoint spPointCopy(SPPoint source) {
+	size_t coordinatesSize;
+	SPPoint item;
+
 	assert (source != NULL);
 	if (source->data == NULL)
 		return NULL;
-	return spPointCreate(source->data,source->dim,source->index);
+
+	coordinatesSize = sizeof(double) * (size_t) source->dim;
+	item = spPointAllocate(source->dim, source->index, coordinatesSize);
+	if (item == NULL) // allocation error
+		return NULL;
+
+	if (spPointIsInline(source)) { // the header, norm and coordinates at once
+		memcpy(item, source, sizeof(struct sp_point_t) + coordinatesSize);
+		item->data = item->storage;
+		return item;
+	}
+	memcpy(item->data, source->data, coordinatesSize);
+	item->squaredNorm = spPointGetSquaredNormInline(source);
+	return item;
 }
 
 void spPointDestroy(SPPoint point) {
-	if (point != NULL) {
-		if (point->data != NULL) {
-			free(point->data);
-			point->data = NULL;
-		}
+	SPPointOwner* owner;
+
+	if (point == NULL)
+		return;
 
-		free(point);
-		point = NULL;
+	if (!spPointIsInline(point)) {
+		owner = spPointGetOwner(point);
+		if (owner->kind == SP_POINT_BATCH) //released with its batch
+			return;
+		if (owner->kind == SP_POINT_OWNED && owner->destructor != NULL)
+			owner->destructor(point->data, owner->context);
+		else if (owner->kind == SP_POINT_OWNED)
+			free(point->data);
 	}
+
+	free(point);
+}
+
+void spPointDestroyBatch(SPPoint* points, int n) {
+	void* block;
+	int i;
+
+	if (points == NULL || n <= 0 || points[0] == NULL)
+		return;
+
+	assert(!spPointIsInline(points[0])
+			&& spPointGetOwner(points[0])->kind == SP_POINT_BATCH);
+	block = spPointGetOwner(points[0])->context;
+	for (i = 0; i < n; i++)
+		points[i] = NULL;
+	free(block);
 }
 
 int spPointGetDimension(SPPoint point) {
-	assert(point != NULL);
-	return point->dim;
+	return spPointGetDimensionInline(point);
 }
 
 int spPointGetIndex(SPPoint point) {
-	assert(point != NULL);
-	return point->index;
+	return spPointGetIndexInline(point);
 }
 
 double spPointGetAxisCoor(SPPoint point, int axis) {
-	assert(point != NULL && axis < point->dim && axis >= 0);
-	return point->data[axis];
+	return spPointGetAxisCoorInline(point, axis);
 }
 
 double spPointL2SquaredDistance(SPPoint p, SPPoint q) {
-	int dimIndex;
-	double l2Dist = 0, currentDist;
+	return spPointL2SquaredDistanceInline(p, q);
+}
+
+double spPointGetSquaredNorm(SPPoint point) {
+	return spPointGetSquaredNormInline(point);
+}
 
+double spPointL1Distance(SPPoint p, SPPoint q) {
 	assert(p != NULL && q != NULL && p->dim == q->dim);
+	return spDistanceL1(p->data, q->data, p->dim);
+}
 
-	for (dimIndex = 0;dimIndex < p->dim ; dimIndex++) {
-		currentDist = p->data[dimIndex]-q->data[dimIndex];
-		l2Dist += currentDist * currentDist;
-	}
+double spPointInnerProduct(SPPoint p, SPPoint q) {
+	assert(p != NULL && q != NULL && p->dim == q->dim);
+	return spDistanceInnerProduct(p->data, q->data, p->dim);
+}
 
-	return l2Dist;
+double spPointCosineDistance(SPPoint p, SPPoint q) {
+	assert(p != NULL && q != NULL && p->dim == q->dim);
+	return spDistanceCosine(spDistanceInnerProduct(p->data, q->data, p->dim),
+			spPointGetSquaredNormInline(p), spPointGetSquaredNormInline(q));
 }
 
+void spPointL2SquaredDistanceMany(SPPoint q, const SPPoint* pts, int n, double* out) {
+	const double* block[SP_DISTANCE_BLOCK_SIZE];
+	SPDistanceBlockKernel kernel;
+	int i, j, count;
+
+	assert(q != NULL && n >= 0 && (n == 0 || (pts != NULL && out != NULL)));
+
+	kernel = spDistanceL2SquaredBlockFor(q->dim);
+
+	for (i = 0; i < n; i += SP_DISTANCE_BLOCK_SIZE) {
+		count = n - i < SP_DISTANCE_BLOCK_SIZE ? n - i : SP_DISTANCE_BLOCK_SIZE;
+		for (j = 0; j < count; j++) {
+			assert(pts[i + j] != NULL && pts[i + j]->dim == q->dim);
+			block[j] = pts[i + j]->data;
+		}
+		// the coordinates of the next block and the headers of the one after it
+		for (j = i + count; j < i + count + SP_DISTANCE_BLOCK_SIZE && j < n; j++) {
+			spDistancePrefetch(pts[j]->data);
+			if (j + SP_DISTANCE_BLOCK_SIZE < n)
+				spDistancePrefetch(pts[j + SP_DISTANCE_BLOCK_SIZE]);
+		}
+		kernel(q->data, block, count, q->dim, out + i);
+	}
+}
@@ -1,6 +1,8 @@
 #ifndef SPPOINT_H_
 #define SPPOINT_H_
 
+#include <stdbool.h>
+
 /**
  * SPPoint Summary
  * Encapsulates a point with variable length dimension. The coordinates
@@ -10,18 +12,34 @@
  * The following functions are supported:
  *
  * spPointCreate        	- Creates a new point
+ * spPointCreateOwned		- Creates a new point which adopts a given coordinates array
+ * spPointCreateView		- Creates a new point which borrows a given coordinates array
+ * spPointCreateBatch		- Creates the points of the rows of a matrix in one allocation
  * spPointCopy				- Create a new copy of a given point
  * spPointDestroy 			- Free all resources associated with a point
+ * spPointDestroyBatch		- Free all resources associated with the points of a batch
  * spPointGetDimension		- A getter of the dimension of a point
  * spPointGetIndex			- A getter of the index of a point
  * spPointGetAxisCoor		- A getter of a given coordinate of the point
+ * spPointGetSquaredNorm	- A getter of the squared L2 norm of the point
  * spPointL2SquaredDistance	- Calculates the L2 squared distance between two points
+ * spPointL2SquaredDistanceMany - Calculates the L2 squared distances of a point to many points
+ * spPointL1Distance		- Calculates the L1 distance between two points
+ * spPointInnerProduct		- Calculates the inner product of two points
+ * spPointCosineDistance	- Calculates the cosine distance between two points
  *
  */
 
 /** Type for defining the point **/
 typedef struct sp_point_t* SPPoint;
 
+/**
+ * Type of the callback releasing the coordinates array adopted by a point
+ * created with spPointCreateOwned.
+ * data is the adopted array and context is the context given on creation.
+ */
+typedef void (*SPPointDataDestructor)(double* data, void* context);
+
 /**
  * Allocates a new point in the memory.
  * Given data array, dimension dim and an index.
@@ -38,6 +56,72 @@ typedef struct sp_point_t* SPPoint;
  */
 SPPoint spPointCreate(double* data, int dim, int index);
 
+/**
+ * Allocates a new point in the memory which adopts the given data array,
+ * the coordinates are not copied.
+ * The new point is the same as the one created by spPointCreate(data, dim, index).
+ *
+ * Lifetime rules:
+ * - On success the point owns data, the caller must not free or change it.
+ *   spPointDestroy releases data by calling destructor(data, context), or by
+ *   free(data) if destructor is NULL (in which case data must be allocated by malloc).
+ * - On failure (NULL is returned) the ownership of data stays with the caller.
+ * - spPointCopy of the point returns an independent point holding a copy of data.
+ *
+ * @param data - The coordinates array to adopt
+ * @param dim - The dimension of the point (the number of coordinates in data)
+ * @param index - The index of the point
+ * @param destructor - The callback releasing data, NULL to release it by free
+ * @param context - The context passed to destructor, may be NULL
+ * @return
+ * NULL in case allocation failure ocurred OR data is NULL OR dim <=0 OR index <0
+ * Otherwise, the new point is returned
+ */
+SPPoint spPointCreateOwned(double* data, int dim, int index,
+		SPPointDataDestructor destructor, void* context);
+
+/**
+ * Allocates a new point in the memory which borrows the given data array,
+ * the coordinates are not copied.
+ * The new point is the same as the one created by spPointCreate(data, dim, index),
+ * as long as data is not changed.
+ *
+ * Lifetime rules:
+ * - The caller keeps the ownership of data, it must stay valid until the point
+ *   is destroyed. spPointDestroy does not release data.
+ * - Changes of data are seen by the point.
+ * - spPointCopy of the point returns an independent point holding a copy of data.
+ *
+ * @param data - The coordinates array to borrow
+ * @param dim - The dimension of the point (the number of coordinates in data)
+ * @param index - The index of the point
+ * @return
+ * NULL in case allocation failure ocurred OR data is NULL OR dim <=0 OR index <0
+ * Otherwise, the new point is returned
+ */
+SPPoint spPointCreateView(double* data, int dim, int index);
+
+/**
+ * Creates n points from the rows of the n x dim row-major matrix, such that
+ * out[i] is the point created by spPointCreate(&matrix[i * dim], dim, indices[i]).
+ * All the points and their coordinates are allocated as one block, the
+ * coordinates are copied by a single memcpy.
+ *
+ * The points of a batch are released together by spPointDestroyBatch,
+ * spPointDestroy of a single point of a batch does nothing.
+ *
+ * @param matrix - The coordinates of the points, n rows of dim coordinates
+ * @param n - The number of points
+ * @param dim - The dimension of the points
+ * @param indices - The indices of the points, NULL to index the points 0...n-1
+ * @param out - An array of at least n points which receives the new points
+ * @return
+ * false in case allocation failure ocurred OR matrix is NULL OR out is NULL
+ * OR n <= 0 OR dim <= 0 OR indices[i] < 0 for some i (out is not changed)
+ * Otherwise, true is returned
+ */
+bool spPointCreateBatch(const double* matrix, int n, int dim, const int* indices, SPPoint* out);
+
 /**
  * Allocates a copy of the given point.
  *
@@ -58,9 +142,23 @@ SPPoint spPointCopy(SPPoint source);
 /**
  * Free all memory allocation associated with point,
  * if point is NULL nothing happens.
+ * The coordinates array of a point created by spPointCreateOwned is released
+ * by its destructor, the one of a point created by spPointCreateView is not released.
+ * A point created by spPointCreateBatch is not released (see spPointDestroyBatch).
  */
 void spPointDestroy(SPPoint point);
 
+/**
+ * Free all memory allocation associated with the n points created by
+ * spPointCreateBatch. The points may be given in any order, all of them
+ * must belong to the same batch, and they are set to NULL.
+ * If points is NULL or n <= 0 nothing happens.
+ *
+ * @param points - The points of the batch
+ * @param n - The number of points of the batch
+ */
+void spPointDestroyBatch(SPPoint* points, int n);
+
 /**
  * A getter for the dimension of the point
  *
@@ -93,6 +191,19 @@ int spPointGetIndex(SPPoint point);
  */
 double spPointGetAxisCoor(SPPoint point, int axis);
 
+/**
+ * A getter for the squared L2 norm of the point, p_0^2 + ... + p_{dim-1}^2
+ * The norm is computed once when the point is created, except for a point
+ * created by spPointCreateView, whose norm is computed on every call because
+ * its coordinates may change.
+ *
+ * @param point - The source point
+ * @assert point != NULL
+ * @return
+ * The squared L2 norm of the point
+ */
+double spPointGetSquaredNorm(SPPoint point);
+
 /**
  * Calculates the L2-squared distance between p and q.
  * The L2-squared distance is defined as:
@@ -106,5 +217,66 @@ double spPointGetAxisCoor(SPPoint point, int axis);
  */
 double spPointL2SquaredDistance(SPPoint p, SPPoint q);
 
+/**
+ * Calculates the L2-squared distances between q and each of the n points pts,
+ * such that out[i] is the L2-squared distance between q and pts[i].
+ * The coordinates of q are loaded once for every block of points, and the
+ * upcoming points are prefetched. The distances are summed by the vectorised
+ * kernels of SPDistance.h, so they may differ from spPointL2SquaredDistance
+ * in the last bits.
+ *
+ * @param q - The query point
+ * @param pts - The points, n points with the dimension of q
+ * @param n - The number of points
+ * @param out - An array of at least n distances
+ * @assert q!=NULL AND (n == 0 OR (pts!=NULL AND out!=NULL)) AND n >= 0
+ * 		   AND dim(pts[i]) == dim(q) for every i
+ */
+void spPointL2SquaredDistanceMany(SPPoint q, const SPPoint* pts, int n, double* out);
+
+/**
+ * Calculates the L1 distance between p and q.
+ * The L1 distance is defined as:
+ * |p_1 - q_1| + |p_2 - q_2| + ... + |p_dim - q_dim|
+ * The distance is summed by the vectorised kernels of SPDistance.h.
+ *
+ * @param p - The first point
+ * @param q - The second point
+ * @assert p!=NULL AND q!=NULL AND dim(p) == dim(q)
+ * @return
+ * The L1 distance between p and q
+ */
+double spPointL1Distance(SPPoint p, SPPoint q);
+
+/**
+ * Calculates the inner product of p and q.
+ * The inner product is defined as:
+ * p_1 * q_1 + p_2 * q_2 + ... + p_dim * q_dim
+ * The product is summed by the vectorised kernels of SPDistance.h.
+ *
+ * @param p - The first point
+ * @param q - The second point
+ * @assert p!=NULL AND q!=NULL AND dim(p) == dim(q)
+ * @return
+ * The inner product of p and q
+ */
+double spPointInnerProduct(SPPoint p, SPPoint q);
+
+/**
+ * Calculates the cosine distance between p and q.
+ * The cosine distance is defined as:
+ * 1 - (p_1 * q_1 + ... + p_dim * q_dim) / (||p|| * ||q||)
+ * The norms are the cached norms of spPointGetSquaredNorm, so only the inner
+ * product is computed. The distance is in [0, 2], and is 1 if p or q is the
+ * zero vector.
+ *
+ * @param p - The first point
+ * @param q - The second point
+ * @assert p!=NULL AND q!=NULL AND dim(p) == dim(q)
+ * @return
+ * The cosine distance between p and q
+ */
+double spPointCosineDistance(SPPoint p, SPPoint q);
+
 
 #endif /* SPPOINT_H_ */
@@ -0,0 +1,120 @@
+#ifndef SPPOINTINTERNAL_H_
+#define SPPOINTINTERNAL_H_
+
+#include "SPPoint.h"
+#include "SPDistance.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * SPPoint internal summary
+ *
+ * Exposes the layout of SPPoint and inline variants of its hot accessors to the
+ * trusted modules of this library (SPPoint and the search code), so the compiler
+ * can inline them and vectorise the loops over the coordinates.
+ * External users must include SPPoint.h only, the layout is not part of the API.
+ *
+ * The inline variants have the same semantics as the corresponding functions:
+ *   spPointGetDimensionInline     - see spPointGetDimension
+ *   spPointGetIndexInline         - see spPointGetIndex
+ *   spPointGetAxisCoorInline      - see spPointGetAxisCoor
+ *   spPointL2SquaredDistanceInline - see spPointL2SquaredDistance
+ *   spPointGetSquaredNormInline   - see spPointGetSquaredNorm
+ */
+
+// The alignment of the coordinates of a batch of points and of the rows of a store
+#define SP_POINT_ALIGNMENT 64
+
+/*
+ * A structure used for the point data type
+ * The point is allocated as one malloc block.
+ * The coordinates of a point created by spPointCreate follow the header in the
+ * flexible array member storage. A point created by spPointCreateOwned,
+ * spPointCreateView or spPointCreateBatch holds an SPPointOwner in storage
+ * instead, and data points to the adopted, borrowed or batch array.
+ * data - an array of the axis data of the point
+ * dim - an integer representing the dimension of the point
+ * index -  an integer representing the image index related to the point
+ * squaredNorm - the squared L2 norm of the coordinates, computed on creation
+ *               (not used by view points, whose coordinates may change)
+ * storage - the coordinates of the point, or its SPPointOwner
+ */
+struct sp_point_t {
+	double* data;
+	int dim;
+	int index;
+	double squaredNorm;
+	double storage[];
+};
+
+/** The owners of the coordinates array of a point which does not hold them in storage **/
+typedef enum sp_point_owner_kind_t {
+	SP_POINT_OWNED, // adopted by the point, released on destroy
+	SP_POINT_VIEW, // borrowed from the caller
+	SP_POINT_BATCH // part of a batch block, released by spPointDestroyBatch
+} SP_POINT_OWNER_KIND;
+
+/*
+ * The owner of the coordinates array of a point which does not hold them in storage
+ * kind - who owns the array
+ * destructor - the callback releasing an adopted array, NULL for free
+ * context - the context passed to destructor, the block of a batch point
+ */
+typedef struct sp_point_owner_t {
+	SP_POINT_OWNER_KIND kind;
+	SPPointDataDestructor destructor;
+	void* context;
+} SPPointOwner;
+
+// true if the coordinates of the point are stored in its own block
+static inline bool spPointIsInline(SPPoint point) {
+	return point->data == point->storage;
+}
+
+// the owner of the coordinates array of a point which is not inline
+static inline SPPointOwner* spPointGetOwner(SPPoint point) {
+	return (SPPointOwner*) (void*) point->storage;
+}
+
+static inline int spPointGetDimensionInline(SPPoint point) {
+	assert(point != NULL);
+	return point->dim;
+}
+
+static inline int spPointGetIndexInline(SPPoint point) {
+	assert(point != NULL);
+	return point->index;
+}
+
+static inline double spPointGetAxisCoorInline(SPPoint point, int axis) {
+	assert(point != NULL && axis < point->dim && axis >= 0);
+	return point->data[axis];
+}
+
+static inline double spPointL2SquaredDistanceInline(SPPoint p, SPPoint q) {
+	int dimIndex;
+	double l2Dist = 0, currentDist;
+	const double* pData;
+	const double* qData;
+
+	assert(p != NULL && q != NULL && p->dim == q->dim);
+
+	pData = p->data;
+	qData = q->data;
+	for (dimIndex = 0; dimIndex < p->dim; dimIndex++) {
+		currentDist = pData[dimIndex] - qData[dimIndex];
+		l2Dist += currentDist * currentDist;
+	}
+
+	return l2Dist;
+}
+
+static inline double spPointGetSquaredNormInline(SPPoint point) {
+	assert(point != NULL);
+	if (!spPointIsInline(point) && spPointGetOwner(point)->kind == SP_POINT_VIEW)
+		return spDistanceSquaredNorm(point->data, point->dim);
+	return point->squaredNorm;
+}
+
+#endif /* SPPOINTINTERNAL_H_ */
@@ -0,0 +1,160 @@
+#define _POSIX_C_SOURCE 200112L
+#include "SPPointStoreInternal.h"
+#include "SPPointInternal.h"
+#include "SPDistance.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// The number of coordinates of each precision in a cache line, every row is padded to a multiple of it
+#define SP_POINT_STORE_ROW_ALIGNMENT (SP_POINT_ALIGNMENT / sizeof(double))
+#define SP_POINT_STORE_HALF_ROW_ALIGNMENT (SP_POINT_ALIGNMENT / sizeof(uint16_t))
+
+/*
+ * copies the coordinates of a point to a row of a half precision store and computes
+ * the squared norm of the rounded coordinates
+ * @store - the store
+ * @i - the position of the row
+ * @point - the point
+ */
+void spPointStoreSetHalfRow(SPPointStore store, int i, SPPoint point) {
+	uint16_t* row = store->halfRows + (size_t) i * store->stride;
+	double norm = 0.0, value;
+	int axis;
+
+	spDistanceToHalf(point->data, row, store->dim);
+	memset(row + store->dim, 0, sizeof(uint16_t) * (store->stride - (size_t) store->dim));
+	for (axis = 0; axis < store->dim; axis++) {
+		value = spDistanceHalfToFloat(row[axis]);
+		norm += value * value;
+	}
+	store->norms[i] = norm;
+}
+
+SPPointStore spPointStoreCreate(const SPPoint* points, int n) {
+	return spPointStoreCreateWithPrecision(points, n, SP_POINT_STORE_DOUBLE);
+}
+
+SPPointStore spPointStoreCreateWithPrecision(const SPPoint* points, int n,
+		SP_POINT_STORE_PRECISION precision) {
+	SPPointStore store;
+	size_t alignment, valueSize;
+	void* rows;
+	int i;
+
+	if (points == NULL || n <= 0 || points[0] == NULL) //illegal arguments
+		return NULL;
+	if (precision != SP_POINT_STORE_DOUBLE && precision != SP_POINT_STORE_HALF)
+		return NULL;
+	for (i = 1; i < n; i++) {
+		if (points[i] == NULL || points[i]->dim != points[0]->dim) //illegal point
+			return NULL;
+	}
+
+	store = (SPPointStore) calloc(1, sizeof(struct sp_point_store_t));
+	if (store == NULL) //allocation error
+		return NULL;
+	store->size = n;
+	store->dim = points[0]->dim;
+	store->precision = precision;
+	store->l2Block = spDistanceL2SquaredBlockFor(store->dim);
+	store->l2Strided = spDistanceL2SquaredStridedFor(store->dim);
+	alignment = precision == SP_POINT_STORE_HALF ? SP_POINT_STORE_HALF_ROW_ALIGNMENT
+			: SP_POINT_STORE_ROW_ALIGNMENT;
+	valueSize = precision == SP_POINT_STORE_HALF ? sizeof(uint16_t) : sizeof(double);
+	store->stride = ((size_t) store->dim + alignment - 1) / alignment * alignment;
+	store->indices = (int*) malloc(sizeof(int) * (size_t) n);
+	store->norms = (double*) malloc(sizeof(double) * (size_t) n);
+	if (store->indices == NULL || store->norms == NULL
+			|| posix_memalign(&rows, SP_POINT_ALIGNMENT, valueSize * store->stride * (size_t) n) != 0) {
+		spPointStoreDestroy(store); //allocation error
+		return NULL;
+	}
+	if (precision == SP_POINT_STORE_HALF)
+		store->halfRows = (uint16_t*) rows;
+	else
+		store->rows = (double*) rows;
+
+	for (i = 0; i < n; i++) {
+		store->indices[i] = points[i]->index;
+		if (precision == SP_POINT_STORE_HALF) {
+			spPointStoreSetHalfRow(store, i, points[i]);
+			continue;
+		}
+		memcpy(store->rows + (size_t) i * store->stride, points[i]->data,
+				sizeof(double) * (size_t) store->dim);
+		// the padding is zeroed so it never holds invalid values
+		memset(store->rows + (size_t) i * store->stride + store->dim, 0,
+				sizeof(double) * (store->stride - (size_t) store->dim));
+		store->norms[i] = spPointGetSquaredNormInline(points[i]);
+	}
+
+	return store;
+}
+
+void spPointStoreDestroy(SPPointStore store) {
+	if (store != NULL) {
+		free(store->rows);
+		free(store->halfRows);
+		free(store->indices);
+		free(store->norms);
+		free(store);
+	}
+}
+
+int spPointStoreGetSize(SPPointStore store) {
+	assert(store != NULL);
+	return store->size;
+}
+
+int spPointStoreGetDimension(SPPointStore store) {
+	assert(store != NULL);
+	return store->dim;
+}
+
+SP_POINT_STORE_PRECISION spPointStoreGetPrecision(SPPointStore store) {
+	assert(store != NULL);
+	return store->precision;
+}
+
+int spPointStoreGetIndex(SPPointStore store, int i) {
+	assert(store != NULL && i >= 0 && i < store->size);
+	return store->indices[i];
+}
+
+double spPointStoreGetSquaredNorm(SPPointStore store, int i) {
+	assert(store != NULL && i >= 0 && i < store->size);
+	return store->norms[i];
+}
+
+double spPointStoreGetAxisCoor(SPPointStore store, int i, int axis) {
+	assert(store != NULL && i >= 0 && i < store->size && axis >= 0 && axis < store->dim);
+	if (store->precision == SP_POINT_STORE_HALF)
+		return spDistanceHalfToFloat(store->halfRows[(size_t) i * store->stride + (size_t) axis]);
+	return store->rows[(size_t) i * store->stride + (size_t) axis];
+}
+
+void spPointStoreL2SquaredDistanceMany(SPPointStore store, SPPoint q, double* out) {
+	assert(store != NULL && q != NULL && out != NULL && q->dim == store->dim);
+	if (store->precision == SP_POINT_STORE_HALF) {
+		spDistanceL2SquaredHalfStrided(q->data, store->halfRows, store->size, store->dim,
+				store->stride, out);
+		return;
+	}
+	store->l2Strided(q->data, store->rows, store->size, store->dim, store->stride, out);
+}
+
+bool spPointStoreL2SquaredDistanceMatrix(SPPointStore queries, int first, int count,
+		SPPointStore store, double* out) {
+	assert(queries != NULL && store != NULL && out != NULL && queries->dim == store->dim);
+	assert(first >= 0 && count >= 0 && first + count <= queries->size);
+	// the matrix kernel reads double rows, which half precision stores do not have
+	if (queries->precision != SP_POINT_STORE_DOUBLE || store->precision != SP_POINT_STORE_DOUBLE)
+		return false;
+	if (count == 0)
+		return true;
+	spDistanceL2SquaredMatrix(spPointStoreGetRowInline(queries, first), queries->norms + first,
+			count, queries->stride, store->rows, store->norms, store->size, store->stride,
+			store->dim, out, (size_t) store->size);
+	return true;
+}
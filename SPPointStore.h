@@ -0,0 +1,190 @@
+#ifndef SPPOINTSTORE_H_
+#define SPPOINTSTORE_H_
+
+#include "SPPoint.h"
+
+/**
+ * SPPointStore Summary
+ * Encapsulates an immutable collection of points of the same dimension, stored
+ * contiguously: the coordinates of every point are a row of one aligned matrix,
+ * and each row starts on its own cache line. The store keeps the index and the
+ * squared norm of every point, and is the layout used for scanning many points
+ * per query.
+ *
+ * The coordinates are stored as doubles, or optionally as half precision (fp16)
+ * values, which take a quarter of the memory and of the bandwidth per distance.
+ * A half precision store keeps the coordinates rounded to the nearest half
+ * (relative error at most 2^-11, values beyond 65504 become infinite), and its
+ * distances are computed in single precision.
+ *
+ * The following functions are supported:
+ *
+ * spPointStoreCreate					- Creates a new store holding copies of given points
+ * spPointStoreCreateWithPrecision		- Creates a new store holding copies of given points
+ * 										  with coordinates of a given precision
+ * spPointStoreDestroy					- Free all resources associated with a store
+ * spPointStoreGetSize					- A getter of the number of points in a store
+ * spPointStoreGetDimension				- A getter of the dimension of the points in a store
+ * spPointStoreGetPrecision				- A getter of the precision of the coordinates of a store
+ * spPointStoreGetIndex					- A getter of the index of a point in a store
+ * spPointStoreGetAxisCoor				- A getter of a given coordinate of a point in a store
+ * spPointStoreGetSquaredNorm			- A getter of the squared norm of a point in a store
+ * spPointStoreL2SquaredDistanceMany	- Calculates the L2 squared distances of a point
+ * 										  to all the points of a store
+ * spPointStoreL2SquaredDistanceMatrix	- Calculates the L2 squared distances of the points
+ * 										  of a store to all the points of another store
+ */
+
+/** Type for defining the point store **/
+typedef struct sp_point_store_t* SPPointStore;
+
+/** Type used to choose the precision of the stored coordinates **/
+typedef enum sp_point_store_precision_t {
+	SP_POINT_STORE_DOUBLE, // the coordinates of the points
+	SP_POINT_STORE_HALF // the coordinates rounded to half precision (IEEE 754 binary16)
+} SP_POINT_STORE_PRECISION;
+
+/**
+ * Allocates a new store holding copies of the n given points,
+ * such that the i-th point of the store has the coordinates and the index of points[i].
+ * The store does not keep references to the given points.
+ *
+ * @param points - The points to store
+ * @param n - The number of points
+ * @return
+ * NULL in case allocation failure ocurred OR points is NULL OR n <= 0 OR
+ * points[i] is NULL for some i OR the points do not have the same dimension
+ * Otherwise, the new store is returned
+ */
+SPPointStore spPointStoreCreate(const SPPoint* points, int n);
+
+/**
+ * Allocates a new store holding copies of the n given points, as spPointStoreCreate,
+ * with coordinates of the given precision. The coordinates of a SP_POINT_STORE_HALF
+ * store are rounded by spDistanceFloatToHalf, and the squared norms of its points are
+ * those of the rounded coordinates.
+ *
+ * @param points - The points to store
+ * @param n - The number of points
+ * @param precision - The precision of the stored coordinates
+ * @return
+ * NULL in case allocation failure ocurred OR points is NULL OR n <= 0 OR
+ * points[i] is NULL for some i OR the points do not have the same dimension OR
+ * precision is not a SP_POINT_STORE_PRECISION
+ * Otherwise, the new store is returned
+ */
+SPPointStore spPointStoreCreateWithPrecision(const SPPoint* points, int n,
+		SP_POINT_STORE_PRECISION precision);
+
+/**
+ * Free all memory allocation associated with store,
+ * if store is NULL nothing happens.
+ */
+void spPointStoreDestroy(SPPointStore store);
+
+/**
+ * A getter for the number of points in the store
+ *
+ * @param store - The source store
+ * @assert store != NULL
+ * @return
+ * The number of points in the store
+ */
+int spPointStoreGetSize(SPPointStore store);
+
+/**
+ * A getter for the dimension of the points in the store
+ *
+ * @param store - The source store
+ * @assert store != NULL
+ * @return
+ * The dimension of the points in the store
+ */
+int spPointStoreGetDimension(SPPointStore store);
+
+/**
+ * A getter for the precision of the coordinates stored in the store
+ *
+ * @param store - The source store
+ * @assert store != NULL
+ * @return
+ * The precision of the coordinates of the store
+ */
+SP_POINT_STORE_PRECISION spPointStoreGetPrecision(SPPointStore store);
+
+/**
+ * A getter for the index of the i-th point in the store
+ *
+ * @param store - The source store
+ * @param i - The position of the point in the store
+ * @assert store != NULL AND 0 <= i < size(store)
+ * @return
+ * The index of the i-th point
+ */
+int spPointStoreGetIndex(SPPointStore store, int i);
+
+/**
+ * A getter for specific coordinate value of the i-th point in the store
+ *
+ * @param store - The source store
+ * @param i - The position of the point in the store
+ * @param axis - The coordinate of the point which its value will be retreived
+ * @assert store != NULL AND 0 <= i < size(store) AND 0 <= axis < dim(store)
+ * @return
+ * The value of the given coordinate of the i-th point, as stored
+ */
+double spPointStoreGetAxisCoor(SPPointStore store, int i, int axis);
+
+/**
+ * A getter for the squared L2 norm of the i-th point in the store, which is
+ * computed once when the store is created
+ *
+ * @param store - The source store
+ * @param i - The position of the point in the store
+ * @assert store != NULL AND 0 <= i < size(store)
+ * @return
+ * The squared L2 norm of the i-th point
+ */
+double spPointStoreGetSquaredNorm(SPPointStore store, int i);
+
+/**
+ * Calculates the L2-squared distances between q and every point of the store,
+ * such that out[i] is the L2-squared distance between q and the i-th point.
+ * The rows are scanned in order by the kernels of SPDistance.h, so the
+ * distances may differ from spPointL2SquaredDistance in the last bits.
+ * The distances to the points of a SP_POINT_STORE_HALF store are computed in
+ * single precision by spDistanceL2SquaredHalfStrided.
+ *
+ * @param store - The source store
+ * @param q - The query point
+ * @param out - An array of at least size(store) distances
+ * @assert store != NULL AND q != NULL AND out != NULL AND dim(q) == dim(store)
+ */
+void spPointStoreL2SquaredDistanceMany(SPPointStore store, SPPoint q, double* out);
+
+/**
+ * Calculates the L2-squared distances between the count points of queries,
+ * starting at position first, and every point of store, such that
+ * out[i * size(store) + j] is the distance between the (first + i)-th query
+ * and the j-th point of store.
+ * The distances are computed by the cache blocked norm decomposition of
+ * spDistanceL2SquaredMatrix, which is much faster for many queries but loses
+ * precision when a distance is much smaller than the squared norms of its
+ * points (see spDistanceL2SquaredMatrixError).
+ *
+ * @param queries - The store of the queries
+ * @param first - The position of the first query
+ * @param count - The number of queries
+ * @param store - The source store
+ * @param out - An array of at least count * size(store) distances
+ * @assert queries != NULL AND store != NULL AND out != NULL AND dim(queries) == dim(store)
+ * 		   AND first >= 0 AND count >= 0 AND first + count <= size(queries)
+ * @return
+ * false, leaving out unchanged, if the precision of either store is not
+ * SP_POINT_STORE_DOUBLE, use spPointStoreL2SquaredDistanceMany for half precision stores
+ * Otherwise, true
+ */
+bool spPointStoreL2SquaredDistanceMatrix(SPPointStore queries, int first, int count,
+		SPPointStore store, double* out);
+
+#endif /* SPPOINTSTORE_H_ */
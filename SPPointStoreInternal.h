@@ -0,0 +1,58 @@
+#ifndef SPPOINTSTOREINTERNAL_H_
+#define SPPOINTSTOREINTERNAL_H_
+
+#include "SPPointStore.h"
+#include "SPDistance.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * SPPointStore internal summary
+ *
+ * Exposes the layout of SPPointStore to the trusted modules of this library
+ * (the search code), so they can scan the rows of a store directly.
+ * External users must include SPPointStore.h only, the layout is not part of the API.
+ */
+
+/*
+ * A structure used for the point store data type
+ * size - the number of points
+ * dim - the dimension of the points
+ * precision - the type of the stored coordinates
+ * stride - the distance between the beginnings of two rows, in coordinates
+ * rows - the coordinates matrix of a SP_POINT_STORE_DOUBLE store, size rows of
+ *        stride doubles, SP_POINT_ALIGNMENT aligned, NULL otherwise
+ * halfRows - the coordinates matrix of a SP_POINT_STORE_HALF store, size rows of
+ *            stride half precision values, SP_POINT_ALIGNMENT aligned, NULL otherwise
+ * indices - the indices of the points
+ * norms - the squared norms of the stored coordinates
+ * l2Block, l2Strided - the L2 squared kernels of the dimension of the store, selected
+ *                      once by spDistanceL2SquaredBlockFor and spDistanceL2SquaredStridedFor
+ */
+struct sp_point_store_t {
+	int size;
+	int dim;
+	SP_POINT_STORE_PRECISION precision;
+	size_t stride;
+	double* rows;
+	uint16_t* halfRows;
+	int* indices;
+	double* norms;
+	SPDistanceBlockKernel l2Block;
+	SPDistanceStridedKernel l2Strided;
+};
+
+// the coordinates of the i-th point of a SP_POINT_STORE_DOUBLE store
+static inline const double* spPointStoreGetRowInline(SPPointStore store, int i) {
+	assert(store != NULL && store->rows != NULL && i >= 0 && i < store->size);
+	return store->rows + (size_t) i * store->stride;
+}
+
+// the coordinates of the i-th point of a SP_POINT_STORE_HALF store
+static inline const uint16_t* spPointStoreGetHalfRowInline(SPPointStore store, int i) {
+	assert(store != NULL && store->halfRows != NULL && i >= 0 && i < store->size);
+	return store->halfRows + (size_t) i * store->stride;
+}
+
+#endif /* SPPOINTSTOREINTERNAL_H_ */
@@ -0,0 +1,162 @@
+#ifndef BENCH_PERF_H_
+#define BENCH_PERF_H_
+
+/**
+ * Benchmark hardware counters summary
+ *
+ * Reads hardware performance counters of the calling thread around a benchmark
+ * using perf_event_open. Counters are opened one by one, so a counter which is
+ * not supported by the machine (or not permitted, see perf_event_paranoid) is
+ * reported as unavailable while the others are still read.
+ * On systems other than Linux all counters are unavailable.
+ * The including source file must define _DEFAULT_SOURCE before its first include.
+ *
+ * benchPerfCounterName - Returns the name of a counter, as used in the reports
+ * benchPerfOpen        - Opens the counters
+ * benchPerfClose       - Closes the counters
+ * benchPerfStart       - Resets and enables the counters
+ * benchPerfStop        - Disables the counters and reads their values
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/** The counters read around every benchmark **/
+typedef enum bench_perf_counter_t {
+	BENCH_PERF_CYCLES,
+	BENCH_PERF_INSTRUCTIONS,
+	BENCH_PERF_L1D_MISSES,
+	BENCH_PERF_LLC_MISSES,
+	BENCH_PERF_BRANCH_MISSES,
+	BENCH_PERF_COUNTERS
+} BENCH_PERF_COUNTER;
+
+
+/*
+ * The open counters
+ * fds - the file descriptor of every counter, -1 if unavailable
+ * values - the values read by the last benchPerfStop
+ */
+typedef struct bench_perf_t {
+	int fds[BENCH_PERF_COUNTERS];
+	double values[BENCH_PERF_COUNTERS];
+} BenchPerf;
+
+static inline const char* benchPerfCounterName(BENCH_PERF_COUNTER counter) {
+	switch (counter) {
+		case BENCH_PERF_CYCLES:
+			return "cycles";
+		case BENCH_PERF_INSTRUCTIONS:
+			return "instructions";
+		case BENCH_PERF_L1D_MISSES:
+			return "l1d_misses";
+		case BENCH_PERF_LLC_MISSES:
+			return "llc_misses";
+		case BENCH_PERF_BRANCH_MISSES:
+			return "branch_misses";
+		default:
+			return NULL;
+	}
+}
+
+#ifdef __linux__
+static inline int benchPerfOpenCounter(unsigned int type, unsigned long long config) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = type;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+//returns true if at least one counter is available
+static inline bool benchPerfOpen(BenchPerf* perf) {
+	int i;
+	bool available = false;
+
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++) {
+		perf->fds[i] = -1;
+		perf->values[i] = 0;
+	}
+#ifdef __linux__
+	perf->fds[BENCH_PERF_CYCLES] = benchPerfOpenCounter(PERF_TYPE_HARDWARE,
+			PERF_COUNT_HW_CPU_CYCLES);
+	perf->fds[BENCH_PERF_INSTRUCTIONS] = benchPerfOpenCounter(PERF_TYPE_HARDWARE,
+			PERF_COUNT_HW_INSTRUCTIONS);
+	perf->fds[BENCH_PERF_L1D_MISSES] = benchPerfOpenCounter(PERF_TYPE_HW_CACHE,
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	perf->fds[BENCH_PERF_LLC_MISSES] = benchPerfOpenCounter(PERF_TYPE_HARDWARE,
+			PERF_COUNT_HW_CACHE_MISSES);
+	perf->fds[BENCH_PERF_BRANCH_MISSES] = benchPerfOpenCounter(PERF_TYPE_HARDWARE,
+			PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++)
+		available = available || perf->fds[i] >= 0;
+	return available;
+}
+
+static inline void benchPerfClose(BenchPerf* perf) {
+	int i;
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++) {
+#ifdef __linux__
+		if (perf->fds[i] >= 0)
+			close(perf->fds[i]);
+#endif
+		perf->fds[i] = -1;
+	}
+}
+
+static inline void benchPerfStart(BenchPerf* perf) {
+#ifdef __linux__
+	int i;
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++) {
+		if (perf->fds[i] >= 0) {
+			ioctl(perf->fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(perf->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#else
+	(void) perf;
+#endif
+}
+
+//unavailable counters are read as -1
+static inline void benchPerfStop(BenchPerf* perf) {
+	int i;
+#ifdef __linux__
+	unsigned long long value;
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++) {
+		if (perf->fds[i] >= 0)
+			ioctl(perf->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+#endif
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++) {
+		perf->values[i] = -1;
+#ifdef __linux__
+		if (perf->fds[i] >= 0 && read(perf->fds[i], &value, sizeof(value)) == sizeof(value))
+			perf->values[i] = (double) value;
+#endif
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_PERF_H_ */
@@ -0,0 +1,185 @@
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+/**
+ * Benchmark utilities summary
+ *
+ * Timing and statistics helpers shared by the benchmark executables.
+ * The including source file must define _DEFAULT_SOURCE before its first include,
+ * as the clock is read with clock_gettime and the counters of bench_perf.h are
+ * opened with syscall.
+ *
+ * benchNowNanoseconds  - Returns the current time of a monotonic clock in nanoseconds
+ * benchSortSamples     - Sorts an array of samples in ascending order
+ * benchPercentile      - Returns a percentile of an array of sorted samples
+ * benchRun             - Measures a benchmark with warmup and repetitions, and
+ *                        optionally its hardware counters
+ * benchPrintResult     - Prints a result as a human readable line
+ * benchWriteJson       - Writes results as a JSON document
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bench_perf.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_NAME_SIZE 64
+#define BENCH_MAX_REPETITIONS 1000
+
+/*
+ * The result of a measured benchmark, all times are in nanoseconds per operation
+ * name - the name of the benchmark
+ * repetitions - the number of measured repetitions
+ * operations - the number of operations in a single repetition
+ * median, p99, min, mean - statistics of the repetitions
+ * mad - the median absolute deviation of the repetitions, used as the noise estimate
+ * hasCounters - true if the hardware counters were read
+ * counters - the value per operation of every counter, -1 if it is unavailable
+ */
+typedef struct bench_result_t {
+	char name[BENCH_NAME_SIZE];
+	int repetitions;
+	double operations;
+	double median;
+	double p99;
+	double min;
+	double mean;
+	double mad;
+	bool hasCounters;
+	double counters[BENCH_PERF_COUNTERS];
+} BenchResult;
+
+static inline double benchNowNanoseconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec * 1e9 + (double) now.tv_nsec;
+}
+
+static inline int benchCompareSamples(const void* first, const void* second) {
+	double a = *(const double*) first, b = *(const double*) second;
+	return (a > b) - (a < b);
+}
+
+static inline void benchSortSamples(double* samples, int count) {
+	qsort(samples, (size_t) count, sizeof(double), benchCompareSamples);
+}
+
+/*
+ * percentile in [0,100], samples must be sorted and count > 0
+ * the nearest rank: the sample at ceil(percentile / 100 * count) - 1, clamped to the
+ * samples, the ceiling is taken by hand so the benchmarks need not link the math library
+ */
+static inline double benchPercentile(const double* sortedSamples, int count, double percentile) {
+	double position = percentile / 100.0 * (double) count;
+	int rank = (int) position;
+	if ((double) rank < position)
+		rank++;
+	rank--;
+	if (rank < 0)
+		rank = 0;
+	if (rank >= count)
+		rank = count - 1;
+	return sortedSamples[rank];
+}
+
+/*
+ * Runs warmup unmeasured repetitions of run and then measures repetitions
+ * repetitions of it. A single call of run performs operations operations.
+ * repetitions must be in [1, BENCH_MAX_REPETITIONS].
+ * If perf is not NULL its counters are read around the measured repetitions.
+ */
+static inline void benchRun(const char* name, void (*run)(void*), void* context,
+		double operations, int warmup, int repetitions, BenchPerf* perf, BenchResult* result) {
+	double samples[BENCH_MAX_REPETITIONS], deviations[BENCH_MAX_REPETITIONS];
+	double start, sum = 0;
+	int i;
+
+	for (i = 0; i < warmup; i++)
+		run(context);
+	if (perf != NULL)
+		benchPerfStart(perf);
+	for (i = 0; i < repetitions; i++) {
+		start = benchNowNanoseconds();
+		run(context);
+		samples[i] = (benchNowNanoseconds() - start) / operations;
+		sum += samples[i];
+	}
+	if (perf != NULL)
+		benchPerfStop(perf);
+
+	result->hasCounters = perf != NULL;
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++) {
+		result->counters[i] = perf == NULL || perf->values[i] < 0 ? -1
+				: perf->values[i] / (operations * repetitions);
+	}
+
+	benchSortSamples(samples, repetitions);
+	strncpy(result->name, name, BENCH_NAME_SIZE - 1);
+	result->name[BENCH_NAME_SIZE - 1] = '\0';
+	result->repetitions = repetitions;
+	result->operations = operations;
+	result->median = benchPercentile(samples, repetitions, 50);
+	result->p99 = benchPercentile(samples, repetitions, 99);
+	result->min = samples[0];
+	result->mean = sum / repetitions;
+	for (i = 0; i < repetitions; i++)
+		deviations[i] = samples[i] > result->median ? samples[i] - result->median
+				: result->median - samples[i];
+	benchSortSamples(deviations, repetitions);
+	result->mad = benchPercentile(deviations, repetitions, 50);
+}
+
+static inline void benchPrintResult(FILE* output, const BenchResult* result) {
+	int i;
+	fprintf(output, "%-40s median=%10.2f ns/op p99=%10.2f ns/op min=%10.2f ns/op mad=%8.2f\n",
+			result->name, result->median, result->p99, result->min, result->mad);
+	if (!result->hasCounters)
+		return;
+	fprintf(output, "%-40s", "");
+	for (i = 0; i < BENCH_PERF_COUNTERS; i++) {
+		if (result->counters[i] < 0)
+			fprintf(output, " %s=n/a", benchPerfCounterName((BENCH_PERF_COUNTER) i));
+		else
+			fprintf(output, " %s=%.3f/op", benchPerfCounterName((BENCH_PERF_COUNTER) i),
+					result->counters[i]);
+	}
+	fprintf(output, "\n");
+}
+
+/*
+ * Writes the results as a JSON document of the form:
+ * {"benchmarks": [{"name": ..., "repetitions": ..., "operations": ...,
+ *   "median_ns": ..., "p99_ns": ..., "min_ns": ..., "mean_ns": ..., "mad_ns": ...}, ...]}
+ * Available hardware counters are added to the benchmark objects as
+ * "<counter>_per_op" keys.
+ */
+static inline void benchWriteJson(FILE* output, const BenchResult* results, int count) {
+	int i, counter;
+	fprintf(output, "{\n  \"benchmarks\": [\n");
+	for (i = 0; i < count; i++) {
+		fprintf(output, "    {\"name\": \"%s\", \"repetitions\": %d, \"operations\": %.0f, "
+				"\"median_ns\": %.4f, \"p99_ns\": %.4f, \"min_ns\": %.4f, "
+				"\"mean_ns\": %.4f, \"mad_ns\": %.4f", results[i].name,
+				results[i].repetitions, results[i].operations, results[i].median,
+				results[i].p99, results[i].min, results[i].mean, results[i].mad);
+		for (counter = 0; results[i].hasCounters && counter < BENCH_PERF_COUNTERS; counter++) {
+			if (results[i].counters[counter] >= 0)
+				fprintf(output, ", \"%s_per_op\": %.4f",
+						benchPerfCounterName((BENCH_PERF_COUNTER) counter), results[i].counters[counter]);
+		}
+		fprintf(output, "}%s\n", i + 1 < count ? "," : "");
+	}
+	fprintf(output, "  ]\n}\n");
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_UTIL_H_ */
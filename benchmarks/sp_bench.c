@@ -0,0 +1,796 @@
+#define _DEFAULT_SOURCE
+#include "bench_util.h"
+#include "../SPBPriorityQueue.h"
+#include "../SPList.h"
+#include "../SPListElement.h"
+#include "../SPPoint.h"
+#include "../SPPointStore.h"
+#include "../SPKNNSearch.h"
+#include "../SPBinaryPoint.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define BENCH_HEAP_FOOTPRINT
+#endif
+
+/*
+ * Data structures benchmark
+ * Measures the hot paths of SPBPQueue, SPList and SPPoint in ns/op:
+ * 	bpqueue_enqueue/<distribution>/k=<capacity> - enqueue of ENQUEUE_ELEMENTS elements
+ * 	bpqueue_enqueue/<backend>/<distribution>/k=<capacity> - the same enqueues to a queue of
+ * 		each backend
+ * 	bpqueue_interleaved/<backend>/k=<capacity> - ENQUEUE_ELEMENTS pairs of a dequeue and an
+ * 		enqueue to a full queue of each backend
+ * 	list_insert_first, list_insert_last, list_iterate - over LIST_ELEMENTS elements
+ * 	point_l2/dim=<dim> - L2 squared distance between POINTS pairs of points
+ * 	point_l1/dim=<dim>, point_inner_product/dim=<dim>, point_cosine/dim=<dim> - the other
+ * 		metrics of SPPoint between the same pairs of points
+ * 	point_l2_many/dim=<dim> - L2 squared distances of a point to POINTS points
+ * 	point_store_l2_many/dim=<dim> - L2 squared distances of a point to a store of POINTS points
+ * 	point_store_half_l2_many/dim=<dim> - the same distances to a half precision store
+ * 	knn_store/dim=<dim>, knn_batch/<fast|exact>/dim=<dim> - search of the KNN_K nearest of
+ * 		KNN_QUERIES queries among KNN_POINTS points, one query at a time and as a batch
+ * 	knn_store_half/dim=<dim> - the single query search of a half precision store
+ * 	knn_store/k=<k>/dim=<dim> - the single query search of the nearest (k=1) and the two
+ * 		nearest (k=2) points, which keeps the neighbours out of the queue
+ * 	knn_store/<backend>/k=<k>/dim=<dim> - the single query search with a result queue
+ * 		of each backend, which is read after every accepted neighbour
+ * 	knn_binary/bits=<bits> - search of the KNN_K nearest of KNN_QUERIES binary queries
+ * 		among KNN_POINTS binary points by the Hamming distance
+ * 	point_create_destroy/<layout>/dim=<dim> - creation and destruction of POINTS points,
+ * 		as a single block (SPPoint), as the former two allocations layout
+ * 		and as one batch (spPointCreateBatch)
+ *
+ * The heap footprint of POINTS points of each layout is printed to stderr where
+ * the C library reports it (glibc).
+ *
+ * With --perf the hardware counters of bench_perf.h are read around every
+ * benchmark and reported per operation.
+ *
+ * usage: ./sp_bench [--repetitions N] [--warmup N] [--json FILE] [--filter SUBSTRING] [--perf]
+ */
+
+#define DEFAULT_REPETITIONS 15
+#define DEFAULT_WARMUP 3
+#define MAX_RESULTS 256
+#define ENQUEUE_ELEMENTS 10000
+#define LIST_ELEMENTS 10000
+#define POINTS 1024
+#define KNN_QUERIES 64
+#define KNN_POINTS 8192
+#define KNN_K 10
+#define RANDOM_VALUE_RANGE 1000.0
+#define RANDOM_SEED 20160
+
+/** Input distributions of the enqueue benchmarks **/
+typedef enum bench_distribution_t {
+	BENCH_RANDOM,
+	BENCH_SORTED,
+	BENCH_REVERSE_SORTED
+} BENCH_DISTRIBUTION;
+
+static const char* distributionNames[] = { "random", "sorted", "reverse" };
+static const SP_BPQUEUE_BACKEND backends[] = { SP_BPQUEUE_LIST, SP_BPQUEUE_MIN_MAX_HEAP,
+		SP_BPQUEUE_SORTED_ARRAY, SP_BPQUEUE_LAZY };
+static const char* backendNames[] = { "list", "heap", "sorted", "lazy" };
+static const int capacities[] = { 1, 16, 64, 128, 1024 };
+static const int dimensions[] = { 2, 3, 4, 8, 16, 32, 64, 128, 256, 512 };
+static const int createDimensions[] = { 2, 16, 128 };
+static const int knnDimensions[] = { 16, 128 };
+static const int knnCapacities[] = { 16, 128, 1024 };
+static const int knnBinaryBits[] = { 256, 512 };
+
+/*
+ * The harness configuration and results
+ */
+typedef struct bench_config_t {
+	int repetitions;
+	int warmup;
+	const char* filter;
+	BenchPerf* perf;
+	BenchResult results[MAX_RESULTS];
+	int count;
+} BenchConfig;
+
+/*
+ * The context of the queue and list benchmarks
+ * elements - the elements inserted in every repetition
+ * count - the number of elements
+ * queue, list - the containers the elements are inserted to
+ */
+typedef struct bench_containers_t {
+	SPListElement* elements;
+	int count;
+	SPBPQueue queue;
+	SPList list;
+} BenchContainers;
+
+/*
+ * A point of the former SPPoint layout, the header and the coordinates are
+ * two separate allocations. Used as the baseline of the creation benchmark.
+ */
+typedef struct bench_two_alloc_point_t {
+	double* data;
+	int dim;
+	int index;
+} BenchTwoAllocPoint;
+
+/*
+ * The context of the point benchmarks
+ * points - the points, twoAllocPoints - the points of the baseline layout
+ * count - the number of points
+ * data, dim - the coordinates matrix of the points, count rows of dim coordinates
+ * store - the points as a store, distances - count distances
+ */
+typedef struct bench_points_t {
+	SPPoint* points;
+	BenchTwoAllocPoint** twoAllocPoints;
+	int count;
+	double* data;
+	int dim;
+	SPPointStore store;
+	double* distances;
+} BenchPoints;
+
+/*
+ * The context of the search benchmarks
+ * store - the searched points, queries - the queries
+ * queryPoints - the queries as points, results - a result queue per query
+ * nearest - result queues of capacity k per query for k = 1, 2, nearestK - the k searched
+ * queue - a result queue shared by the queries
+ */
+typedef struct bench_knn_t {
+	SPPointStore store;
+	SPPointStore queries;
+	SPPoint* queryPoints;
+	SPBPQueue* results;
+	SPBPQueue* nearest[2];
+	int nearestK;
+	SPBPQueue queue;
+} BenchKNN;
+
+/*
+ * The context of the binary search benchmarks
+ * points - the searched binary points, queries - the binary queries
+ * results - a result queue per query
+ */
+typedef struct bench_knn_binary_t {
+	SPBinaryPoint* points;
+	SPBinaryPoint* queries;
+	SPBPQueue* results;
+} BenchKNNBinary;
+
+// prevents the compiler from removing the measured computations
+static volatile double sink;
+
+static bool matchesFilter(BenchConfig* config, const char* name) {
+	return config->filter == NULL || strstr(name, config->filter) != NULL;
+}
+
+//measures a benchmark if it matches the filter and stores its result
+static void measure(BenchConfig* config, const char* name, void (*run)(void*),
+		void* context, double operations) {
+	if (!matchesFilter(config, name))
+		return;
+	if (config->count == MAX_RESULTS)
+		return;
+	benchRun(name, run, context, operations, config->warmup, config->repetitions,
+			config->perf, &config->results[config->count]);
+	benchPrintResult(stdout, &config->results[config->count]);
+	fflush(stdout);
+	config->count++;
+}
+
+static double randomValue() {
+	return (double) rand() / ((double) RAND_MAX / RANDOM_VALUE_RANGE);
+}
+
+//creates count elements of the given distribution, returns NULL on allocation failure
+static SPListElement* createElements(int count, BENCH_DISTRIBUTION distribution) {
+	int i;
+	double value;
+	SPListElement* elements = (SPListElement*) calloc((size_t) count, sizeof(SPListElement));
+	if (elements == NULL)
+		return NULL;
+	for (i = 0; i < count; i++) {
+		if (distribution == BENCH_RANDOM)
+			value = randomValue();
+		else if (distribution == BENCH_SORTED)
+			value = (double) i;
+		else
+			value = (double) (count - i);
+		elements[i] = spListElementCreate(i, value);
+	}
+	return elements;
+}
+
+static void destroyElements(SPListElement* elements, int count) {
+	int i;
+	if (elements == NULL)
+		return;
+	for (i = 0; i < count; i++)
+		spListElementDestroy(elements[i]);
+	free(elements);
+}
+
+static void runEnqueue(void* context) {
+	BenchContainers* containers = (BenchContainers*) context;
+	int i;
+	spBPQueueClear(containers->queue);
+	for (i = 0; i < containers->count; i++)
+		spBPQueueEnqueue(containers->queue, containers->elements[i]);
+}
+
+static void runInterleaved(void* context) {
+	BenchContainers* containers = (BenchContainers*) context;
+	int i, capacity = spBPQueueGetMaxSize(containers->queue);
+	spBPQueueClear(containers->queue);
+	for (i = 0; i < capacity && i < containers->count; i++)
+		spBPQueueEnqueue(containers->queue, containers->elements[i]);
+	for (i = 0; i < containers->count; i++) {
+		spBPQueueDequeue(containers->queue);
+		spBPQueueEnqueue(containers->queue, containers->elements[i]);
+	}
+}
+
+static void runListInsertFirst(void* context) {
+	BenchContainers* containers = (BenchContainers*) context;
+	int i;
+	spListClear(containers->list);
+	for (i = 0; i < containers->count; i++)
+		spListInsertFirst(containers->list, containers->elements[i]);
+}
+
+static void runListInsertLast(void* context) {
+	BenchContainers* containers = (BenchContainers*) context;
+	int i;
+	spListClear(containers->list);
+	for (i = 0; i < containers->count; i++)
+		spListInsertLast(containers->list, containers->elements[i]);
+}
+
+static void runListIterate(void* context) {
+	BenchContainers* containers = (BenchContainers*) context;
+	double sum = 0;
+	SPListElement current = spListGetFirst(containers->list);
+	while (current != NULL) {
+		sum += spListElementGetValue(current);
+		current = spListGetNext(containers->list);
+	}
+	sink = sum;
+}
+
+static void runPointL2(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	double sum = 0;
+	int i;
+	for (i = 0; i < points->count; i++)
+		sum += spPointL2SquaredDistance(points->points[i], points->points[(i + 1) % points->count]);
+	sink = sum;
+}
+
+static void runPointL1(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	double sum = 0;
+	int i;
+	for (i = 0; i < points->count; i++)
+		sum += spPointL1Distance(points->points[i], points->points[(i + 1) % points->count]);
+	sink = sum;
+}
+
+static void runPointInnerProduct(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	double sum = 0;
+	int i;
+	for (i = 0; i < points->count; i++)
+		sum += spPointInnerProduct(points->points[i], points->points[(i + 1) % points->count]);
+	sink = sum;
+}
+
+static void runPointCosine(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	double sum = 0;
+	int i;
+	for (i = 0; i < points->count; i++)
+		sum += spPointCosineDistance(points->points[i], points->points[(i + 1) % points->count]);
+	sink = sum;
+}
+
+static void runPointL2Many(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	spPointL2SquaredDistanceMany(points->points[0], points->points, points->count, points->distances);
+	sink = points->distances[points->count - 1];
+}
+
+static void runPointStoreL2Many(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	spPointStoreL2SquaredDistanceMany(points->store, points->points[0], points->distances);
+	sink = points->distances[points->count - 1];
+}
+
+static void runKNNStore(void* context) {
+	BenchKNN* knn = (BenchKNN*) context;
+	int i;
+	for (i = 0; i < KNN_QUERIES; i++)
+		spKNNSearchStore(knn->store, knn->queryPoints[i], knn->results[i]);
+}
+
+static void runKNNStoreNearest(void* context) {
+	BenchKNN* knn = (BenchKNN*) context;
+	int i;
+	for (i = 0; i < KNN_QUERIES; i++)
+		spKNNSearchStore(knn->store, knn->queryPoints[i], knn->nearest[knn->nearestK - 1][i]);
+}
+
+static void runKNNStoreQueue(void* context) {
+	BenchKNN* knn = (BenchKNN*) context;
+	int i;
+	for (i = 0; i < KNN_QUERIES; i++)
+		spKNNSearchStore(knn->store, knn->queryPoints[i], knn->queue);
+}
+
+static void runKNNBatchFast(void* context) {
+	BenchKNN* knn = (BenchKNN*) context;
+	spKNNSearchBatch(knn->store, knn->queries, SP_KNN_FAST, knn->results);
+}
+
+static void runKNNBatchExact(void* context) {
+	BenchKNN* knn = (BenchKNN*) context;
+	spKNNSearchBatch(knn->store, knn->queries, SP_KNN_EXACT, knn->results);
+}
+
+static void runKNNBinary(void* context) {
+	BenchKNNBinary* knn = (BenchKNNBinary*) context;
+	int i;
+	for (i = 0; i < KNN_QUERIES; i++)
+		spKNNSearchBinary(knn->queries[i], knn->points, KNN_POINTS, knn->results[i]);
+}
+
+static BenchTwoAllocPoint* twoAllocPointCreate(double* data, int dim, int index) {
+	int i;
+	BenchTwoAllocPoint* point = (BenchTwoAllocPoint*) calloc(1, sizeof(BenchTwoAllocPoint));
+	if (point == NULL)
+		return NULL;
+	point->data = (double*) calloc((size_t) dim, sizeof(double));
+	if (point->data == NULL) {
+		free(point);
+		return NULL;
+	}
+	for (i = 0; i < dim; i++)
+		point->data[i] = data[i];
+	point->dim = dim;
+	point->index = index;
+	return point;
+}
+
+static void twoAllocPointDestroy(BenchTwoAllocPoint* point) {
+	if (point != NULL) {
+		free(point->data);
+		free(point);
+	}
+}
+
+static void runPointCreateDestroy(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	int i;
+	for (i = 0; i < points->count; i++)
+		points->points[i] = spPointCreate(points->data + i * points->dim, points->dim, i);
+	for (i = 0; i < points->count; i++)
+		spPointDestroy(points->points[i]);
+}
+
+static void runPointCreateDestroyBatch(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	if (spPointCreateBatch(points->data, points->count, points->dim, NULL, points->points))
+		spPointDestroyBatch(points->points, points->count);
+}
+
+static void runTwoAllocPointCreateDestroy(void* context) {
+	BenchPoints* points = (BenchPoints*) context;
+	int i;
+	for (i = 0; i < points->count; i++)
+		points->twoAllocPoints[i] = twoAllocPointCreate(points->data + i * points->dim, points->dim, i);
+	for (i = 0; i < points->count; i++)
+		twoAllocPointDestroy(points->twoAllocPoints[i]);
+}
+
+//returns the number of heap bytes in use, 0 if the C library does not report it
+static size_t heapInUse() {
+#ifdef BENCH_HEAP_FOOTPRINT
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+//prints the heap footprint per point of both layouts for the context dimension
+static void printPointFootprint(BenchPoints* points) {
+	size_t before, singleBlock, twoAlloc;
+	int i;
+
+	before = heapInUse();
+	for (i = 0; i < points->count; i++)
+		points->points[i] = spPointCreate(points->data, points->dim, i);
+	singleBlock = heapInUse() - before;
+	for (i = 0; i < points->count; i++)
+		spPointDestroy(points->points[i]);
+
+	before = heapInUse();
+	for (i = 0; i < points->count; i++)
+		points->twoAllocPoints[i] = twoAllocPointCreate(points->data, points->dim, i);
+	twoAlloc = heapInUse() - before;
+	for (i = 0; i < points->count; i++)
+		twoAllocPointDestroy(points->twoAllocPoints[i]);
+
+	if (before != 0)
+		fprintf(stderr, "point footprint/dim=%d: single_block %.1f bytes/point, "
+				"two_alloc %.1f bytes/point\n", points->dim,
+				(double) singleBlock / points->count, (double) twoAlloc / points->count);
+}
+
+static bool benchQueue(BenchConfig* config) {
+	char name[BENCH_NAME_SIZE];
+	BenchContainers containers;
+	int distribution;
+	size_t i, b;
+
+	for (distribution = BENCH_RANDOM; distribution <= BENCH_REVERSE_SORTED; distribution++) {
+		containers.count = ENQUEUE_ELEMENTS;
+		containers.elements = createElements(ENQUEUE_ELEMENTS, (BENCH_DISTRIBUTION) distribution);
+		if (containers.elements == NULL)
+			return false;
+		for (i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++) {
+			containers.queue = spBPQueueCreate(capacities[i]);
+			if (containers.queue == NULL) {
+				destroyElements(containers.elements, containers.count);
+				return false;
+			}
+			sprintf(name, "bpqueue_enqueue/%s/k=%d", distributionNames[distribution], capacities[i]);
+			measure(config, name, runEnqueue, &containers, ENQUEUE_ELEMENTS);
+			spBPQueueDestroy(containers.queue);
+			for (b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+				containers.queue = spBPQueueCreateWithBackend(capacities[i], backends[b]);
+				if (containers.queue == NULL) {
+					destroyElements(containers.elements, containers.count);
+					return false;
+				}
+				sprintf(name, "bpqueue_enqueue/%s/%s/k=%d", backendNames[b],
+						distributionNames[distribution], capacities[i]);
+				measure(config, name, runEnqueue, &containers, ENQUEUE_ELEMENTS);
+				if (distribution == BENCH_RANDOM) {
+					sprintf(name, "bpqueue_interleaved/%s/k=%d", backendNames[b], capacities[i]);
+					measure(config, name, runInterleaved, &containers, ENQUEUE_ELEMENTS);
+				}
+				spBPQueueDestroy(containers.queue);
+			}
+		}
+		destroyElements(containers.elements, containers.count);
+	}
+	return true;
+}
+
+static bool benchList(BenchConfig* config) {
+	BenchContainers containers;
+
+	containers.count = LIST_ELEMENTS;
+	containers.elements = createElements(LIST_ELEMENTS, BENCH_RANDOM);
+	containers.list = spListCreate();
+	if (containers.elements == NULL || containers.list == NULL) {
+		destroyElements(containers.elements, containers.count);
+		spListDestroy(containers.list);
+		return false;
+	}
+	measure(config, "list_insert_first", runListInsertFirst, &containers, LIST_ELEMENTS);
+	measure(config, "list_insert_last", runListInsertLast, &containers, LIST_ELEMENTS);
+	runListInsertLast(&containers); //the iteration needs a full list
+	measure(config, "list_iterate", runListIterate, &containers, LIST_ELEMENTS);
+	spListDestroy(containers.list);
+	destroyElements(containers.elements, containers.count);
+	return true;
+}
+
+static bool benchPoint(BenchConfig* config) {
+	char name[BENCH_NAME_SIZE];
+	BenchPoints points;
+	double* data;
+	size_t i;
+	int j, k;
+	bool success = true;
+
+	points.count = POINTS;
+	points.points = (SPPoint*) calloc(POINTS, sizeof(SPPoint));
+	points.distances = (double*) malloc(sizeof(double) * POINTS);
+	data = (double*) malloc(sizeof(double) * (size_t) dimensions[sizeof(dimensions) / sizeof(dimensions[0]) - 1]);
+	if (points.points == NULL || points.distances == NULL || data == NULL) {
+		free(points.points);
+		free(points.distances);
+		free(data);
+		return false;
+	}
+	for (i = 0; i < sizeof(dimensions) / sizeof(dimensions[0]) && success; i++) {
+		for (j = 0; j < POINTS; j++) {
+			for (k = 0; k < dimensions[i]; k++)
+				data[k] = randomValue();
+			points.points[j] = spPointCreate(data, dimensions[i], j);
+			if (points.points[j] == NULL)
+				success = false;
+		}
+		points.store = success ? spPointStoreCreate(points.points, POINTS) : NULL;
+		if (points.store == NULL)
+			success = false;
+		if (success) {
+			sprintf(name, "point_l2/dim=%d", dimensions[i]);
+			measure(config, name, runPointL2, &points, POINTS);
+			sprintf(name, "point_l1/dim=%d", dimensions[i]);
+			measure(config, name, runPointL1, &points, POINTS);
+			sprintf(name, "point_inner_product/dim=%d", dimensions[i]);
+			measure(config, name, runPointInnerProduct, &points, POINTS);
+			sprintf(name, "point_cosine/dim=%d", dimensions[i]);
+			measure(config, name, runPointCosine, &points, POINTS);
+			sprintf(name, "point_l2_many/dim=%d", dimensions[i]);
+			measure(config, name, runPointL2Many, &points, POINTS);
+			sprintf(name, "point_store_l2_many/dim=%d", dimensions[i]);
+			measure(config, name, runPointStoreL2Many, &points, POINTS);
+			spPointStoreDestroy(points.store);
+			points.store = spPointStoreCreateWithPrecision(points.points, POINTS, SP_POINT_STORE_HALF);
+			success = points.store != NULL;
+		}
+		if (success) {
+			sprintf(name, "point_store_half_l2_many/dim=%d", dimensions[i]);
+			measure(config, name, runPointStoreL2Many, &points, POINTS);
+		}
+		spPointStoreDestroy(points.store);
+		for (j = 0; j < POINTS; j++)
+			spPointDestroy(points.points[j]);
+	}
+	free(points.points);
+	free(points.distances);
+	free(data);
+	return success;
+}
+
+//creates count random points of the given dimension, returns false on allocation failure
+static bool createRandomPoints(SPPoint* points, int count, int dim, double* data) {
+	int i, k;
+	for (i = 0; i < count; i++) {
+		for (k = 0; k < dim; k++)
+			data[k] = randomValue();
+		points[i] = spPointCreate(data, dim, i);
+		if (points[i] == NULL)
+			return false;
+	}
+	return true;
+}
+
+static bool benchKNN(BenchConfig* config) {
+	char name[BENCH_NAME_SIZE];
+	BenchKNN knn;
+	SPPoint* points = (SPPoint*) calloc(KNN_POINTS, sizeof(SPPoint));
+	double* data = (double*) malloc(sizeof(double)
+			* (size_t) knnDimensions[sizeof(knnDimensions) / sizeof(knnDimensions[0]) - 1]);
+	bool success = points != NULL && data != NULL;
+	size_t d, b, c;
+	int i, k;
+
+	knn.queryPoints = (SPPoint*) calloc(KNN_QUERIES, sizeof(SPPoint));
+	knn.results = (SPBPQueue*) calloc(KNN_QUERIES, sizeof(SPBPQueue));
+	knn.nearest[0] = (SPBPQueue*) calloc(KNN_QUERIES, sizeof(SPBPQueue));
+	knn.nearest[1] = (SPBPQueue*) calloc(KNN_QUERIES, sizeof(SPBPQueue));
+	success = success && knn.queryPoints != NULL && knn.results != NULL
+			&& knn.nearest[0] != NULL && knn.nearest[1] != NULL;
+	for (i = 0; i < KNN_QUERIES && success; i++) {
+		knn.results[i] = spBPQueueCreate(KNN_K);
+		knn.nearest[0][i] = spBPQueueCreate(1);
+		knn.nearest[1][i] = spBPQueueCreate(2);
+		success = knn.results[i] != NULL && knn.nearest[0][i] != NULL && knn.nearest[1][i] != NULL;
+	}
+	for (d = 0; d < sizeof(knnDimensions) / sizeof(knnDimensions[0]) && success; d++) {
+		success = createRandomPoints(points, KNN_POINTS, knnDimensions[d], data)
+				&& createRandomPoints(knn.queryPoints, KNN_QUERIES, knnDimensions[d], data);
+		knn.store = success ? spPointStoreCreate(points, KNN_POINTS) : NULL;
+		knn.queries = success ? spPointStoreCreate(knn.queryPoints, KNN_QUERIES) : NULL;
+		success = knn.store != NULL && knn.queries != NULL;
+		if (success) {
+			sprintf(name, "knn_store/dim=%d", knnDimensions[d]);
+			measure(config, name, runKNNStore, &knn, KNN_QUERIES);
+			for (k = 1; k <= 2; k++) {
+				knn.nearestK = k;
+				sprintf(name, "knn_store/k=%d/dim=%d", k, knnDimensions[d]);
+				measure(config, name, runKNNStoreNearest, &knn, KNN_QUERIES);
+			}
+			for (b = 0; b < sizeof(backends) / sizeof(backends[0]) && success; b++) {
+				for (c = 0; c < sizeof(knnCapacities) / sizeof(knnCapacities[0]) && success; c++) {
+					knn.queue = spBPQueueCreateWithBackend(knnCapacities[c], backends[b]);
+					success = knn.queue != NULL;
+					if (success) {
+						sprintf(name, "knn_store/%s/k=%d/dim=%d", backendNames[b], knnCapacities[c],
+								knnDimensions[d]);
+						measure(config, name, runKNNStoreQueue, &knn, KNN_QUERIES);
+					}
+					spBPQueueDestroy(knn.queue);
+				}
+			}
+			sprintf(name, "knn_batch/fast/dim=%d", knnDimensions[d]);
+			measure(config, name, runKNNBatchFast, &knn, KNN_QUERIES);
+			sprintf(name, "knn_batch/exact/dim=%d", knnDimensions[d]);
+			measure(config, name, runKNNBatchExact, &knn, KNN_QUERIES);
+			spPointStoreDestroy(knn.store);
+			knn.store = spPointStoreCreateWithPrecision(points, KNN_POINTS, SP_POINT_STORE_HALF);
+			success = knn.store != NULL;
+		}
+		if (success) {
+			sprintf(name, "knn_store_half/dim=%d", knnDimensions[d]);
+			measure(config, name, runKNNStore, &knn, KNN_QUERIES);
+		}
+		spPointStoreDestroy(knn.store);
+		spPointStoreDestroy(knn.queries);
+		for (i = 0; i < KNN_POINTS; i++)
+			spPointDestroy(points[i]);
+		for (i = 0; i < KNN_QUERIES; i++)
+			spPointDestroy(knn.queryPoints[i]);
+		memset(points, 0, sizeof(SPPoint) * KNN_POINTS);
+		memset(knn.queryPoints, 0, sizeof(SPPoint) * KNN_QUERIES);
+	}
+	for (i = 0; i < KNN_QUERIES; i++) {
+		if (knn.results != NULL)
+			spBPQueueDestroy(knn.results[i]);
+		for (k = 0; k < 2; k++) {
+			if (knn.nearest[k] != NULL)
+				spBPQueueDestroy(knn.nearest[k][i]);
+		}
+	}
+	free(knn.results);
+	free(knn.nearest[0]);
+	free(knn.nearest[1]);
+	free(knn.queryPoints);
+	free(points);
+	free(data);
+	return success;
+}
+
+//creates count random binary points of the given number of bits, false on allocation failure
+static bool createRandomBinaryPoints(SPBinaryPoint* points, int count, int bits) {
+	uint64_t words[(512 + 63) / 64];
+	int i, k;
+	for (i = 0; i < count; i++) {
+		for (k = 0; k < (bits + 63) / 64; k++)
+			words[k] = ((uint64_t) rand() << 42) ^ ((uint64_t) rand() << 21) ^ (uint64_t) rand();
+		points[i] = spBinaryPointCreate(words, bits, i);
+		if (points[i] == NULL)
+			return false;
+	}
+	return true;
+}
+
+static bool benchKNNBinary(BenchConfig* config) {
+	char name[BENCH_NAME_SIZE];
+	BenchKNNBinary knn;
+	bool success;
+	size_t b;
+	int i;
+
+	knn.points = (SPBinaryPoint*) calloc(KNN_POINTS, sizeof(SPBinaryPoint));
+	knn.queries = (SPBinaryPoint*) calloc(KNN_QUERIES, sizeof(SPBinaryPoint));
+	knn.results = (SPBPQueue*) calloc(KNN_QUERIES, sizeof(SPBPQueue));
+	success = knn.points != NULL && knn.queries != NULL && knn.results != NULL;
+	for (i = 0; i < KNN_QUERIES && success; i++) {
+		knn.results[i] = spBPQueueCreate(KNN_K);
+		success = knn.results[i] != NULL;
+	}
+	for (b = 0; b < sizeof(knnBinaryBits) / sizeof(knnBinaryBits[0]) && success; b++) {
+		success = createRandomBinaryPoints(knn.points, KNN_POINTS, knnBinaryBits[b])
+				&& createRandomBinaryPoints(knn.queries, KNN_QUERIES, knnBinaryBits[b]);
+		if (success) {
+			sprintf(name, "knn_binary/bits=%d", knnBinaryBits[b]);
+			measure(config, name, runKNNBinary, &knn, KNN_QUERIES);
+		}
+		for (i = 0; i < KNN_POINTS; i++)
+			spBinaryPointDestroy(knn.points[i]);
+		for (i = 0; i < KNN_QUERIES; i++)
+			spBinaryPointDestroy(knn.queries[i]);
+		memset(knn.points, 0, sizeof(SPBinaryPoint) * KNN_POINTS);
+		memset(knn.queries, 0, sizeof(SPBinaryPoint) * KNN_QUERIES);
+	}
+	for (i = 0; knn.results != NULL && i < KNN_QUERIES; i++)
+		spBPQueueDestroy(knn.results[i]);
+	free(knn.results);
+	free(knn.queries);
+	free(knn.points);
+	return success;
+}
+
+static bool benchPointCreate(BenchConfig* config) {
+	char name[BENCH_NAME_SIZE];
+	BenchPoints points;
+	size_t i;
+	int k;
+
+	points.count = POINTS;
+	points.points = (SPPoint*) calloc(POINTS, sizeof(SPPoint));
+	points.twoAllocPoints = (BenchTwoAllocPoint**) calloc(POINTS, sizeof(BenchTwoAllocPoint*));
+	points.data = (double*) malloc(sizeof(double) * POINTS
+			* (size_t) createDimensions[sizeof(createDimensions) / sizeof(createDimensions[0]) - 1]);
+	if (points.points == NULL || points.twoAllocPoints == NULL || points.data == NULL) {
+		free(points.points);
+		free(points.twoAllocPoints);
+		free(points.data);
+		return false;
+	}
+	for (i = 0; i < sizeof(createDimensions) / sizeof(createDimensions[0]); i++) {
+		points.dim = createDimensions[i];
+		for (k = 0; k < POINTS * points.dim; k++)
+			points.data[k] = randomValue();
+		sprintf(name, "point_create_destroy/single_block/dim=%d", points.dim);
+		measure(config, name, runPointCreateDestroy, &points, POINTS);
+		sprintf(name, "point_create_destroy/two_alloc/dim=%d", points.dim);
+		measure(config, name, runTwoAllocPointCreateDestroy, &points, POINTS);
+		sprintf(name, "point_create_destroy/batch/dim=%d", points.dim);
+		measure(config, name, runPointCreateDestroyBatch, &points, POINTS);
+		if (matchesFilter(config, "point_create_destroy/"))
+			printPointFootprint(&points);
+	}
+	free(points.points);
+	free(points.twoAllocPoints);
+	free(points.data);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	static BenchConfig config;
+	BenchPerf perf;
+	const char* jsonFile = NULL;
+	FILE* json;
+	int i;
+
+	config.repetitions = DEFAULT_REPETITIONS;
+	config.warmup = DEFAULT_WARMUP;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+			config.repetitions = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+			config.warmup = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonFile = argv[++i];
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			config.filter = argv[++i];
+		else if (strcmp(argv[i], "--perf") == 0)
+			config.perf = &perf;
+		else
+			config.repetitions = 0; //invalid argument, print usage
+	}
+	if (config.repetitions < 1 || config.repetitions > BENCH_MAX_REPETITIONS || config.warmup < 0) {
+		fprintf(stderr, "usage: %s [--repetitions N] [--warmup N] [--json FILE] [--filter SUBSTRING] "
+				"[--perf]\n",
+				argv[0]);
+		return 1;
+	}
+
+	if (config.perf != NULL && !benchPerfOpen(config.perf)) {
+		fprintf(stderr, "hardware counters are unavailable (check perf_event_paranoid)\n");
+		config.perf = NULL;
+	}
+
+	srand(RANDOM_SEED);
+	if (!benchQueue(&config) || !benchList(&config) || !benchPoint(&config)
+			|| !benchKNN(&config) || !benchKNNBinary(&config) || !benchPointCreate(&config)) {
+		fprintf(stderr, "memory allocation failed\n");
+		return 1;
+	}
+	if (config.perf != NULL)
+		benchPerfClose(config.perf);
+
+	if (jsonFile != NULL) {
+		json = fopen(jsonFile, "w");
+		if (json == NULL) {
+			fprintf(stderr, "cannot open %s\n", jsonFile);
+			return 1;
+		}
+		benchWriteJson(json, config.results, config.count);
+		fclose(json);
+	}
+	return 0;
+}
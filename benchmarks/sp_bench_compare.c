@@ -0,0 +1,215 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Benchmark comparison tool
+ * Compares two JSON results files written by sp_bench --json, a baseline and a
+ * candidate, and reports the change of the median of every benchmark.
+ *
+ * A change is significant only if it is larger than the noise of both runs:
+ * 	|candidate - baseline| > noise * (baseline mad + candidate mad)
+ * A benchmark regressed if the change is significant and the candidate median is
+ * slower than the baseline median by more than threshold percent.
+ *
+ * usage: ./sp_bench_compare [--threshold PERCENT] [--noise FACTOR] BASELINE CANDIDATE
+ * exit status:
+ * 	0 - no benchmark regressed
+ * 	1 - at least one benchmark regressed
+ * 	2 - invalid arguments or unreadable results
+ */
+
+#define DEFAULT_THRESHOLD 5.0
+#define DEFAULT_NOISE 3.0
+#define MAX_NAME_SIZE 64
+#define EXIT_REGRESSION 1
+#define EXIT_INVALID 2
+
+/*
+ * A single benchmark read from a results file
+ */
+typedef struct compare_result_t {
+	char name[MAX_NAME_SIZE];
+	double median;
+	double mad;
+} CompareResult;
+
+/*
+ * The benchmarks of a results file
+ */
+typedef struct compare_results_t {
+	CompareResult* results;
+	int count;
+} CompareResults;
+
+//reads a whole file into a null terminated buffer, NULL on failure
+static char* readFile(const char* fileName) {
+	FILE* file = fopen(fileName, "rb");
+	char* content;
+	long size;
+
+	if (file == NULL)
+		return NULL;
+	if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return NULL;
+	}
+	content = (char*) malloc((size_t) size + 1);
+	if (content != NULL) {
+		if (fread(content, 1, (size_t) size, file) != (size_t) size) {
+			free(content);
+			content = NULL;
+		} else {
+			content[size] = '\0';
+		}
+	}
+	fclose(file);
+	return content;
+}
+
+//finds the number value of "key" between start and end, returns false if missing
+static bool findNumber(const char* start, const char* end, const char* key, double* value) {
+	char quotedKey[MAX_NAME_SIZE];
+	const char* position;
+	char* numberEnd;
+
+	sprintf(quotedKey, "\"%s\"", key);
+	position = strstr(start, quotedKey);
+	if (position == NULL || position >= end)
+		return false;
+	position = strchr(position + strlen(quotedKey), ':');
+	if (position == NULL || position >= end)
+		return false;
+	*value = strtod(position + 1, &numberEnd);
+	return numberEnd != position + 1;
+}
+
+/*
+ * Parses the benchmark objects of a results file. Every object holding a
+ * "name" string and "median_ns" and "mad_ns" numbers is read.
+ */
+static bool parseResults(const char* fileName, CompareResults* parsed) {
+	char* content = readFile(fileName);
+	const char *object, *objectEnd, *name, *nameEnd;
+	int capacity = 0;
+	CompareResult* grown;
+
+	parsed->results = NULL;
+	parsed->count = 0;
+	if (content == NULL)
+		return false;
+
+	for (object = strchr(content, '{'); object != NULL; object = strchr(objectEnd, '{')) {
+		object++;
+		objectEnd = strchr(object, '}');
+		if (objectEnd == NULL)
+			break;
+		nameEnd = strchr(object, '{');
+		if (nameEnd != NULL && nameEnd < objectEnd) { //an enclosing object, continue inside it
+			objectEnd = object;
+			continue;
+		}
+		name = strstr(object, "\"name\"");
+		if (name == NULL || name > objectEnd)
+			continue; //not a benchmark object
+		name = strchr(name + strlen("\"name\""), '"');
+		nameEnd = name == NULL ? NULL : strchr(name + 1, '"');
+		if (nameEnd == NULL || nameEnd > objectEnd || nameEnd - name > MAX_NAME_SIZE)
+			continue;
+
+		if (parsed->count == capacity) {
+			capacity = capacity == 0 ? 64 : capacity * 2;
+			grown = (CompareResult*) realloc(parsed->results, sizeof(CompareResult) * (size_t) capacity);
+			if (grown == NULL) {
+				free(content);
+				return false;
+			}
+			parsed->results = grown;
+		}
+		memcpy(parsed->results[parsed->count].name, name + 1, (size_t) (nameEnd - name - 1));
+		parsed->results[parsed->count].name[nameEnd - name - 1] = '\0';
+		if (findNumber(object, objectEnd, "median_ns", &parsed->results[parsed->count].median)
+				&& findNumber(object, objectEnd, "mad_ns", &parsed->results[parsed->count].mad))
+			parsed->count++;
+	}
+	free(content);
+	return parsed->count > 0;
+}
+
+static const CompareResult* findResult(const CompareResults* results, const char* name) {
+	int i;
+	for (i = 0; i < results->count; i++) {
+		if (strcmp(results->results[i].name, name) == 0)
+			return &results->results[i];
+	}
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+	double threshold = DEFAULT_THRESHOLD, noise = DEFAULT_NOISE, delta, change;
+	const char *baselineFile = NULL, *candidateFile = NULL, *status;
+	CompareResults baseline, candidate;
+	const CompareResult* base;
+	int i, regressions = 0;
+	bool validArguments = true;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+			threshold = atof(argv[++i]);
+		else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+			noise = atof(argv[++i]);
+		else if (baselineFile == NULL)
+			baselineFile = argv[i];
+		else if (candidateFile == NULL)
+			candidateFile = argv[i];
+		else
+			validArguments = false;
+	}
+	if (!validArguments || baselineFile == NULL || candidateFile == NULL || threshold < 0 || noise < 0) {
+		fprintf(stderr, "usage: %s [--threshold PERCENT] [--noise FACTOR] BASELINE CANDIDATE\n", argv[0]);
+		return EXIT_INVALID;
+	}
+	if (!parseResults(baselineFile, &baseline)) {
+		fprintf(stderr, "cannot read benchmark results from %s\n", baselineFile);
+		return EXIT_INVALID;
+	}
+	if (!parseResults(candidateFile, &candidate)) {
+		fprintf(stderr, "cannot read benchmark results from %s\n", candidateFile);
+		free(baseline.results);
+		return EXIT_INVALID;
+	}
+
+	printf("%-40s %12s %12s %9s  %s\n", "benchmark", "baseline", "candidate", "change", "status");
+	for (i = 0; i < candidate.count; i++) {
+		base = findResult(&baseline, candidate.results[i].name);
+		if (base == NULL) {
+			printf("%-40s %12s %12.2f %9s  new\n", candidate.results[i].name, "-",
+					candidate.results[i].median, "-");
+			continue;
+		}
+		delta = candidate.results[i].median - base->median;
+		change = base->median > 0 ? delta / base->median * 100.0 : 0;
+		if ((delta > 0 ? delta : -delta) <= noise * (base->mad + candidate.results[i].mad))
+			status = "noise";
+		else if (change > threshold) {
+			status = "REGRESSION";
+			regressions++;
+		} else if (change < -threshold)
+			status = "improved";
+		else
+			status = "ok";
+		printf("%-40s %12.2f %12.2f %+8.2f%%  %s\n", candidate.results[i].name, base->median,
+				candidate.results[i].median, change, status);
+	}
+	for (i = 0; i < baseline.count; i++) {
+		if (findResult(&candidate, baseline.results[i].name) == NULL)
+			printf("%-40s %12.2f %12s %9s  missing\n", baseline.results[i].name,
+					baseline.results[i].median, "-", "-");
+	}
+	printf("%d regression(s) above %.2f%%\n", regressions, threshold);
+
+	free(baseline.results);
+	free(candidate.results);
+	return regressions > 0 ? EXIT_REGRESSION : 0;
+}
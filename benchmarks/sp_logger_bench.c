@@ -0,0 +1,174 @@
+#define _DEFAULT_SOURCE
+#include "bench_util.h"
+#include "../SPLogger.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Logger benchmark
+ * Measures the throughput and the per call latency of every print level in every
+ * output mode, on a single thread and on several threads.
+ * The stdout output mode writes the records to stdout while the results are
+ * printed to stderr, run as: ./sp_logger_bench [records] [threads] > /dev/null
+ *
+ * The logger is not synchronized, the multi threaded runs rely on the locking of
+ * stdio streams and are therefore done only for the stdout, file and filtered modes.
+ */
+
+#define DEFAULT_RECORDS 200000
+#define DEFAULT_THREADS 4
+#define BENCH_FILE "sp_logger_bench.log"
+#define BENCH_SEGMENT_SIZE (16 * 1024 * 1024)
+#define BENCH_SEGMENTS 2
+#define BENCH_MESSAGE "benchmark record"
+
+/** The output modes measured **/
+typedef enum bench_mode_t {
+	BENCH_MODE_STDOUT,
+	BENCH_MODE_FILE,
+	BENCH_MODE_SEGMENTED,
+	BENCH_MODE_FILTERED
+} BENCH_MODE;
+
+static const char* modeNames[] = { "stdout", "file", "segmented", "filtered" };
+static const char* levelNames[] = { "error", "warning", "info", "debug" };
+
+/*
+ * The work of a single benchmark thread
+ * level - the level of the printed records
+ * records - the number of records to print
+ * latencies - the latency in nanoseconds of every print call
+ */
+typedef struct bench_thread_t {
+	SP_LOGGER_LEVEL level;
+	int records;
+	double* latencies;
+} BenchThread;
+
+//prints a single record of the given level
+static SP_LOGGER_MSG printRecord(SP_LOGGER_LEVEL level) {
+	switch (level) {
+		case SP_LOGGER_ERROR_LEVEL:
+			return spLoggerPrintError(BENCH_MESSAGE, __FILE__, __func__, __LINE__);
+		case SP_LOGGER_WARNING_ERROR_LEVEL:
+			return spLoggerPrintWarning(BENCH_MESSAGE, __FILE__, __func__, __LINE__);
+		case SP_LOGGER_INFO_WARNING_ERROR_LEVEL:
+			return spLoggerPrintInfo(BENCH_MESSAGE);
+		default:
+			return spLoggerPrintDebug(BENCH_MESSAGE, __FILE__, __func__, __LINE__);
+	}
+}
+
+static void* runThread(void* arg) {
+	BenchThread* work = (BenchThread*) arg;
+	double start;
+	int i;
+	for (i = 0; i < work->records; i++) {
+		start = benchNowNanoseconds();
+		printRecord(work->level);
+		work->latencies[i] = benchNowNanoseconds() - start;
+	}
+	return NULL;
+}
+
+//creates the logger of the given mode, all records of level are printed unless filtered
+static bool createLogger(BENCH_MODE mode) {
+	switch (mode) {
+		case BENCH_MODE_STDOUT:
+			return spLoggerCreate(NULL, SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS;
+		case BENCH_MODE_FILE:
+			return spLoggerCreate(BENCH_FILE, SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS;
+		case BENCH_MODE_SEGMENTED:
+			return spLoggerCreateSegmented(BENCH_FILE, SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL,
+					BENCH_SEGMENT_SIZE, BENCH_SEGMENTS) == SP_LOGGER_SUCCESS;
+		default:
+			return spLoggerCreate(BENCH_FILE, SP_LOGGER_ERROR_LEVEL) == SP_LOGGER_SUCCESS;
+	}
+}
+
+//runs a single configuration and prints its results, returns false on failure
+static bool runBenchmark(BENCH_MODE mode, SP_LOGGER_LEVEL level, int records, int threads) {
+	BenchThread* work;
+	pthread_t* handles;
+	double* latencies;
+	double start, elapsed;
+	int i, created = 0, perThread = records / threads;
+	bool success = true;
+
+	latencies = (double*) malloc(sizeof(double) * (size_t) perThread * (size_t) threads);
+	work = (BenchThread*) malloc(sizeof(BenchThread) * (size_t) threads);
+	handles = (pthread_t*) malloc(sizeof(pthread_t) * (size_t) threads);
+	if (latencies == NULL || work == NULL || handles == NULL || !createLogger(mode)) {
+		free(latencies);
+		free(work);
+		free(handles);
+		return false;
+	}
+
+	for (i = 0; i < threads; i++) {
+		work[i].level = level;
+		work[i].records = perThread;
+		work[i].latencies = latencies + (size_t) i * (size_t) perThread;
+	}
+
+	start = benchNowNanoseconds();
+	if (threads == 1) {
+		runThread(&work[0]);
+	} else {
+		//stops at the first failure, the created threads are still joined before the
+		//logger is destroyed, they are logging into it
+		for (created = 0; created < threads; created++) {
+			if (pthread_create(&handles[created], NULL, runThread, &work[created]) != 0) {
+				success = false;
+				break;
+			}
+		}
+		for (i = 0; i < created; i++)
+			pthread_join(handles[i], NULL);
+	}
+	elapsed = benchNowNanoseconds() - start;
+	spLoggerDestroy();
+
+	if (success) {
+		records = perThread * threads;
+		benchSortSamples(latencies, records);
+		fprintf(stderr, "%-9s %-7s threads=%d records/s=%.0f p50=%.0fns p90=%.0fns "
+				"p99=%.0fns p99.9=%.0fns max=%.0fns\n", modeNames[mode], levelNames[level],
+				threads, (double) records / (elapsed / 1e9),
+				benchPercentile(latencies, records, 50), benchPercentile(latencies, records, 90),
+				benchPercentile(latencies, records, 99), benchPercentile(latencies, records, 99.9),
+				latencies[records - 1]);
+	}
+	free(latencies);
+	free(work);
+	free(handles);
+	return success;
+}
+
+int main(int argc, char** argv) {
+	int records = argc > 1 ? atoi(argv[1]) : DEFAULT_RECORDS;
+	int threads = argc > 2 ? atoi(argv[2]) : DEFAULT_THREADS;
+	int mode, level;
+
+	if (records <= 0 || threads <= 0 || records < threads) {
+		fprintf(stderr, "usage: %s [records] [threads] > /dev/null\n", argv[0]);
+		return 1;
+	}
+
+	for (mode = BENCH_MODE_STDOUT; mode <= BENCH_MODE_FILTERED; mode++) {
+		for (level = SP_LOGGER_ERROR_LEVEL; level <= SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL; level++) {
+			if (mode == BENCH_MODE_FILTERED && level == SP_LOGGER_ERROR_LEVEL)
+				continue; //error records are never filtered
+			if (!runBenchmark((BENCH_MODE) mode, (SP_LOGGER_LEVEL) level, records, 1))
+				return 1;
+			if (mode != BENCH_MODE_SEGMENTED && threads > 1
+					&& !runBenchmark((BENCH_MODE) mode, (SP_LOGGER_LEVEL) level, records, threads))
+				return 1;
+		}
+	}
+	remove(BENCH_FILE);
+	remove(BENCH_FILE ".1"); //the rotated segment, BENCH_SEGMENTS is 2
+	return 0;
+}
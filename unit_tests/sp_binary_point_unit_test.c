@@ -0,0 +1,106 @@
+#include "unit_test_util.h"
+#include "../SPBinaryPoint.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RANDOM_TESTS_COUNT 100
+#define RANDOM_TESTS_BITS_RANGE 1100
+
+//fills an array with random 64 bit words
+static void getRandomWords(uint64_t* words, int count) {
+	int i, j;
+	for (i = 0; i < count; i++) {
+		words[i] = 0;
+		for (j = 0; j < 4; j++) {
+			words[i] = (words[i] << 16) | (uint64_t)(rand() & 0xFFFF);
+		}
+	}
+}
+
+//checks the bits and the index of a new point
+bool binaryPointCreateTest() {
+	uint64_t words[2] = { 0x5ULL , 0xFFFFFFFFFFFFFFFFULL };
+	SPBinaryPoint p = spBinaryPointCreate(words, 70, 3);
+	SPBinaryPoint copy;
+	int i;
+	ASSERT_TRUE(p != NULL);
+	words[0] = 0;
+	ASSERT_TRUE(spBinaryPointGetBits(p) == 70);
+	ASSERT_TRUE(spBinaryPointGetIndex(p) == 3);
+	ASSERT_TRUE(spBinaryPointGetBit(p, 0));
+	ASSERT_FALSE(spBinaryPointGetBit(p, 1));
+	ASSERT_TRUE(spBinaryPointGetBit(p, 2));
+	for (i = 64; i < 70; i++) {
+		ASSERT_TRUE(spBinaryPointGetBit(p, i));
+	}
+	copy = spBinaryPointCopy(p);
+	spBinaryPointDestroy(p);
+	ASSERT_TRUE(spBinaryPointGetBits(copy) == 70);
+	ASSERT_TRUE(spBinaryPointGetIndex(copy) == 3);
+	ASSERT_TRUE(spBinaryPointGetBit(copy, 2));
+	spBinaryPointDestroy(copy);
+	return true;
+}
+
+//checks for correct handling of invalid arguments
+bool binaryPointCreateInvalidArgumentsTest() {
+	uint64_t words[1] = { 1 };
+	ASSERT_TRUE(spBinaryPointCreate(NULL, 64, 0) == NULL);
+	ASSERT_TRUE(spBinaryPointCreate(words, 0, 0) == NULL);
+	ASSERT_TRUE(spBinaryPointCreate(words, 64, -1) == NULL);
+	spBinaryPointDestroy(NULL);
+	return true;
+}
+
+//checks that the bits beyond the number of bits never count in a distance
+bool binaryPointHammingDistanceTest() {
+	uint64_t zeros[4] = { 0 , 0 , 0 , 0 };
+	uint64_t ones[4] = { ~0ULL , ~0ULL , ~0ULL , ~0ULL };
+	SPBinaryPoint p = spBinaryPointCreate(zeros, 200, 0);
+	SPBinaryPoint q = spBinaryPointCreate(ones, 200, 1);
+	SPBinaryPoint r = spBinaryPointCreate(ones, 256, 2);
+	SPBinaryPoint s = spBinaryPointCreate(zeros, 256, 3);
+	ASSERT_TRUE(spBinaryPointHammingDistance(p, q) == 200);
+	ASSERT_TRUE(spBinaryPointHammingDistance(q, p) == 200);
+	ASSERT_TRUE(spBinaryPointHammingDistance(q, q) == 0);
+	ASSERT_TRUE(spBinaryPointHammingDistance(r, s) == 256);
+	spBinaryPointDestroy(p);
+	spBinaryPointDestroy(q);
+	spBinaryPointDestroy(r);
+	spBinaryPointDestroy(s);
+	return true;
+}
+
+//compares the Hamming distances of random points to the count of their differing bits
+bool binaryPointRandomTest() {
+	uint64_t words1[(RANDOM_TESTS_BITS_RANGE + 63) / 64];
+	uint64_t words2[(RANDOM_TESTS_BITS_RANGE + 63) / 64];
+	SPBinaryPoint p, q;
+	int test, bits, i, expected;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		bits = 1 + rand() % RANDOM_TESTS_BITS_RANGE;
+		getRandomWords(words1, (bits + 63) / 64);
+		getRandomWords(words2, (bits + 63) / 64);
+		p = spBinaryPointCreate(words1, bits, 0);
+		q = spBinaryPointCreate(words2, bits, 1);
+		expected = 0;
+		for (i = 0; i < bits; i++) {
+			expected += spBinaryPointGetBit(p, i) != spBinaryPointGetBit(q, i);
+		}
+		ASSERT_TRUE(spBinaryPointHammingDistance(p, q) == expected);
+		spBinaryPointDestroy(p);
+		spBinaryPointDestroy(q);
+	}
+	return true;
+}
+
+int main() {
+	srand(0);
+	RUN_TEST(binaryPointCreateTest);
+	RUN_TEST(binaryPointCreateInvalidArgumentsTest);
+	RUN_TEST(binaryPointHammingDistanceTest);
+	RUN_TEST(binaryPointRandomTest);
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <float.h>
 
 #define RANDOM_INDEX_RANGE 300
 #define RANDOM_VALUE_BALANCER 100
@@ -11,6 +12,8 @@
 #define RANDOM_CAPACITY_RANGE 500
 #define RANDOM_SORT_TEST_COUNT 100
 #define DEFAULT_INVALID_NUMBER -1
+#define RANDOM_BACKEND_TEST_COUNT 50
+#define RANDOM_BACKEND_OPERATIONS 2000
 
 //a method used to create a random queue
 static SPBPQueue quickRandomQueue(int capacity, int size) {
@@ -570,6 +573,176 @@ static bool testBPQueueSorted() {
 	}
 	return true;
 }
+//Test for the operation statistics
+static bool testBPQueueStats() {
+	SPListElement e1 = NULL, e2 = NULL, e3 = NULL, e4 = NULL;
+	SPBPQueue queue = NULL, copy = NULL;
+	SPBPQueueStats stats;
+	int i;
+
+	e1 = spListElementCreate(1, 1.0);
+	e2 = spListElementCreate(2, 2.0);
+	e3 = spListElementCreate(3, 3.0);
+	e4 = spListElementCreate(4, 4.0);
+	queue = quickQueue(3, 4, e3, e2, e4, e1); // e1 evicts e4
+	spBPQueueEnqueue(queue, e4); // rejected, larger than the maximum
+	spBPQueueDequeue(queue);
+
+	//test invalid arguments
+	ASSERT_TRUE(spBPQueueGetStats(NULL, &stats) == SP_BPQUEUE_INVALID_ARGUMENT);
+	ASSERT_TRUE(spBPQueueGetStats(queue, NULL) == SP_BPQUEUE_INVALID_ARGUMENT);
+
+	ASSERT_TRUE(spBPQueueGetStats(queue, &stats) == SP_BPQUEUE_SUCCESS);
+#ifdef SP_BPQUEUE_STATS
+	ASSERT_TRUE(stats.enqueueAttempts == 5);
+	ASSERT_TRUE(stats.fastRejects == 1);
+	ASSERT_TRUE(stats.inserts == 4);
+	ASSERT_TRUE(stats.evictions == 1);
+	// e3 at 0, e2 at 0, e4 at 2, e1 at 0
+	ASSERT_TRUE(stats.averageInsertPosition == 0.5);
+	ASSERT_TRUE(stats.peakSize == 3);
+#else
+	ASSERT_TRUE(stats.enqueueAttempts == 0 && stats.inserts == 0 && stats.peakSize == 0);
+#endif
+
+	copy = spBPQueueCopy(queue);
+	ASSERT_TRUE(spBPQueueGetStats(copy, &stats) == SP_BPQUEUE_SUCCESS);
+	ASSERT_TRUE(stats.enqueueAttempts == 0 && stats.inserts == 0 && stats.peakSize == 0);
+	spBPQueueDestroy(queue);
+	spBPQueueDestroy(copy);
+
+	//the heap backends count the levels the inserted elements moved up
+	for (i = 0; i < 2; i++) {
+		queue = spBPQueueCreateWithBackend(3, i == 0 ? SP_BPQUEUE_MIN_MAX_HEAP : SP_BPQUEUE_LAZY);
+		spBPQueueEnqueue(queue, e3);
+		spBPQueueEnqueue(queue, e2);
+		spBPQueueEnqueue(queue, e4);
+		spBPQueueEnqueue(queue, e1);
+		spBPQueueEnqueue(queue, e4);
+		ASSERT_TRUE(spBPQueueGetStats(queue, &stats) == SP_BPQUEUE_SUCCESS);
+#ifdef SP_BPQUEUE_STATS
+		ASSERT_TRUE(stats.fastRejects == 1 && stats.inserts == 4 && stats.evictions == 1);
+		// min-max heap: e2 and e1 move up to the root, lazy max-heap: e4 moves up to the root
+		ASSERT_TRUE(stats.averageInsertPosition == (i == 0 ? 0.5 : 0.25));
+#else
+		ASSERT_TRUE(stats.averageInsertPosition == 0);
+#endif
+		spBPQueueDestroy(queue);
+	}
+
+	spListElementDestroy(e1);
+	spListElementDestroy(e2);
+	spListElementDestroy(e3);
+	spListElementDestroy(e4);
+	return true;
+}
+
+//checks that two queues hold the same items at both ends
+static bool sameEnds(SPBPQueue queue, SPBPQueue expected) {
+	SPListElement e1, e2;
+	ASSERT_TRUE(spBPQueueSize(queue) == spBPQueueSize(expected));
+	ASSERT_TRUE(spBPQueueIsFull(queue) == spBPQueueIsFull(expected));
+	ASSERT_TRUE(spBPQueueMinValue(queue) == spBPQueueMinValue(expected));
+	ASSERT_TRUE(spBPQueueMaxValue(queue) == spBPQueueMaxValue(expected));
+	e1 = spBPQueuePeek(queue);
+	e2 = spBPQueuePeek(expected);
+	ASSERT_TRUE((e1 == NULL && e2 == NULL) || spListElementCompare(e1, e2) == 0);
+	spListElementDestroy(e1);
+	spListElementDestroy(e2);
+	e1 = spBPQueuePeekLast(queue);
+	e2 = spBPQueuePeekLast(expected);
+	ASSERT_TRUE((e1 == NULL && e2 == NULL) || spListElementCompare(e1, e2) == 0);
+	spListElementDestroy(e1);
+	spListElementDestroy(e2);
+	return true;
+}
+
+//Test for the backends, compared to the list backend over random operations
+static bool testBPQueueBackends() {
+	SP_BPQUEUE_BACKEND backends[3] = { SP_BPQUEUE_MIN_MAX_HEAP , SP_BPQUEUE_SORTED_ARRAY ,
+			SP_BPQUEUE_LAZY };
+	SPBPQueue queue = NULL, expected = NULL, copy = NULL;
+	SPListElement elem = NULL;
+	SP_BPQUEUE_MSG message, expectedMessage;
+	SPBPQueueStats stats, expectedStats;
+	double value;
+	int b, test, i, capacity, operation;
+
+	ASSERT_TRUE(spBPQueueCreateWithBackend(3, (SP_BPQUEUE_BACKEND) 100) == NULL);
+	ASSERT_TRUE(spBPQueueCreateWithBackend(-1, SP_BPQUEUE_MIN_MAX_HEAP) == NULL);
+	queue = spBPQueueCreate(SP_BPQUEUE_SORTED_ARRAY_MAX_SIZE);
+	ASSERT_TRUE(spBPQueueGetBackend(queue) == SP_BPQUEUE_SORTED_ARRAY);
+	spBPQueueDestroy(queue);
+	queue = spBPQueueCreate(SP_BPQUEUE_SORTED_ARRAY_MAX_SIZE + 1);
+	ASSERT_TRUE(spBPQueueGetBackend(queue) == SP_BPQUEUE_LIST);
+	spBPQueueDestroy(queue);
+
+	for (b = 0; b < 3; b++) {
+		for (test = 0; test < RANDOM_BACKEND_TEST_COUNT; test++) {
+			capacity = rand() % 80;
+			queue = spBPQueueCreateWithBackend(capacity, backends[b]);
+			expected = spBPQueueCreateWithBackend(capacity, SP_BPQUEUE_LIST);
+			ASSERT_TRUE(queue != NULL && expected != NULL);
+			ASSERT_TRUE(spBPQueueGetBackend(queue) == backends[b]);
+			for (i = 0; i < RANDOM_BACKEND_OPERATIONS; i++) {
+				operation = rand() % 100;
+				if (operation < 75) {
+					//few distinct values and indices, so there are ties and identical items,
+					//and in odd tests values which differ in their last bits only
+					value = (double) (rand() % 16);
+					if (test % 2 == 1) {
+						value *= 1.0 + (rand() % 4) * DBL_EPSILON;
+					}
+					elem = spListElementCreate(rand() % 8, value);
+					message = spBPQueueEnqueue(queue, elem);
+					expectedMessage = spBPQueueEnqueue(expected, elem);
+					ASSERT_TRUE(message == expectedMessage);
+					spListElementDestroy(elem);
+					ASSERT_TRUE(spBPQueueSize(queue) == spBPQueueSize(expected));
+				} else if (operation < 97) {
+					ASSERT_TRUE(spBPQueueDequeue(queue) == spBPQueueDequeue(expected));
+				} else if (operation < 99) {
+					copy = spBPQueueCopy(queue);
+					ASSERT_TRUE(copy != NULL && spBPQueueGetBackend(copy) == backends[b]);
+					ASSERT_TRUE(sameEnds(copy, expected));
+					spBPQueueDestroy(queue);
+					queue = copy;
+					//the copies start with empty statistics
+					copy = spBPQueueCopy(expected);
+					ASSERT_TRUE(copy != NULL);
+					spBPQueueDestroy(expected);
+					expected = copy;
+				} else {
+					spBPQueueClear(queue);
+					spBPQueueClear(expected);
+				}
+				//the ends are not always read, so lazy queues keep many elements in their heap
+				if (operation >= 75 || rand() % 50 == 0) {
+					ASSERT_TRUE(sameEnds(queue, expected));
+				}
+			}
+			//the items leave in the order of the list backend
+			while (!spBPQueueIsEmpty(expected)) {
+				ASSERT_TRUE(sameEnds(queue, expected));
+				ASSERT_TRUE(spBPQueueDequeue(queue) == SP_BPQUEUE_SUCCESS);
+				ASSERT_TRUE(spBPQueueDequeue(expected) == SP_BPQUEUE_SUCCESS);
+			}
+			ASSERT_TRUE(spBPQueueIsEmpty(queue));
+			ASSERT_TRUE(spBPQueueDequeue(queue) == SP_BPQUEUE_EMPTY);
+			//the backends accept, reject and evict the same elements
+			ASSERT_TRUE(spBPQueueGetStats(queue, &stats) == SP_BPQUEUE_SUCCESS);
+			ASSERT_TRUE(spBPQueueGetStats(expected, &expectedStats) == SP_BPQUEUE_SUCCESS);
+			ASSERT_TRUE(stats.enqueueAttempts == expectedStats.enqueueAttempts);
+			ASSERT_TRUE(stats.fastRejects == expectedStats.fastRejects);
+			ASSERT_TRUE(stats.inserts == expectedStats.inserts);
+			ASSERT_TRUE(stats.evictions == expectedStats.evictions);
+			ASSERT_TRUE(stats.peakSize == expectedStats.peakSize);
+			spBPQueueDestroy(queue);
+			spBPQueueDestroy(expected);
+		}
+	}
+	return true;
+}
 
 
 int main() {
@@ -587,6 +760,8 @@ int main() {
 	RUN_TEST(testBPQueueEnqueue);
 	RUN_TEST(testBPQueueDequeue);
 	RUN_TEST(testBPQueueMaxSize0);
+	RUN_TEST(testBPQueueStats);
+	RUN_TEST(testBPQueueBackends);
 
 	return 0;
 }
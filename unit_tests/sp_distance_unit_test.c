@@ -0,0 +1,245 @@
+#include "unit_test_util.h"
+#include "../SPDistance.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define epsilon 0.00001
+#define RANDOM_TESTS_COUNT 100
+#define RANDOM_TESTS_DIM_RANGE 300
+#define RANDOM_TESTS_WORDS_RANGE 20
+#define HALF_LONG_TEST_DIM 2500
+#define HALF_LONG_TEST_ROWS 5
+
+//fills an array with random coordinates in [-50, 50]
+static void getRandomArray(double* data, int dim) {
+	int i;
+	for (i = 0; i < dim; i++) {
+		data[i] = ((double)rand() / ((double)RAND_MAX / 100)) - 50;
+	}
+}
+
+//fills an array with random 64 bit words
+static void getRandomWords(uint64_t* words, int count) {
+	int i, j;
+	for (i = 0; i < count; i++) {
+		words[i] = 0;
+		for (j = 0; j < 4; j++) {
+			words[i] = (words[i] << 16) | (uint64_t)(rand() & 0xFFFF);
+		}
+	}
+}
+
+//the scalar reference of spDistanceL1
+static double referenceL1(const double* p, const double* q, int dim) {
+	double sum = 0;
+	int i;
+	for (i = 0; i < dim; i++) {
+		sum += p[i] > q[i] ? p[i] - q[i] : q[i] - p[i];
+	}
+	return sum;
+}
+
+//the scalar reference of spDistanceInnerProduct
+static double referenceInnerProduct(const double* p, const double* q, int dim) {
+	double sum = 0;
+	int i;
+	for (i = 0; i < dim; i++) {
+		sum += p[i] * q[i];
+	}
+	return sum;
+}
+
+//the scalar reference of spDistanceHamming, bit by bit
+static int referenceHamming(const uint64_t* p, const uint64_t* q, int words) {
+	int count = 0, i, bit;
+	for (i = 0; i < words; i++) {
+		for (bit = 0; bit < 64; bit++) {
+			count += (int)(((p[i] ^ q[i]) >> bit) & 1);
+		}
+	}
+	return count;
+}
+
+//checks the distances of small known arrays
+bool distanceBasicTest() {
+	double p[5] = { 1.0 , -2.0 , 3.0 , 0.0 , 4.0 };
+	double q[5] = { -1.0 , 2.0 , 3.0 , 1.0 , 0.0 };
+	uint64_t a[2] = { 0xFFULL , 0x8000000000000001ULL };
+	uint64_t b[2] = { 0x0FULL , 0x0ULL };
+	ASSERT_TRUE(spDistanceL1(p, q, 5) == 11.0);
+	ASSERT_TRUE(spDistanceInnerProduct(p, q, 5) == 4.0);
+	ASSERT_TRUE(spDistanceL2Squared(p, q, 5) == 37.0);
+	ASSERT_TRUE(spDistanceSquaredNorm(p, 5) == 30.0);
+	ASSERT_TRUE(spDistanceHamming(a, b, 2) == 6);
+	ASSERT_TRUE(spDistanceHamming(a, a, 2) == 0);
+	return true;
+}
+
+//checks the cosine distance of parallel, orthogonal, opposite and zero arrays
+bool distanceCosineTest() {
+	double p[2] = { 3.0 , 4.0 };
+	double q[2] = { 6.0 , 8.0 };
+	double r[2] = { -4.0 , 3.0 };
+	double s[2] = { -3.0 , -4.0 };
+	double zero[2] = { 0.0 , 0.0 };
+	double distance = spDistanceCosine(spDistanceInnerProduct(p, q, 2), 25.0, 100.0);
+	ASSERT_TRUE(distance >= 0.0 && distance < epsilon);
+	ASSERT_TRUE(spDistanceCosine(spDistanceInnerProduct(p, r, 2), 25.0, 25.0) == 1.0);
+	ASSERT_TRUE(spDistanceCosine(spDistanceInnerProduct(p, s, 2), 25.0, 25.0) == 2.0);
+	ASSERT_TRUE(spDistanceCosine(spDistanceInnerProduct(p, zero, 2), 25.0, 0.0) == 1.0);
+	return true;
+}
+
+//compares the vectorised kernels to the scalar references over random arrays
+bool distanceRandomTest() {
+	double p[RANDOM_TESTS_DIM_RANGE];
+	double q[RANDOM_TESTS_DIM_RANGE];
+	uint64_t a[RANDOM_TESTS_WORDS_RANGE];
+	uint64_t b[RANDOM_TESTS_WORDS_RANGE];
+	double diff;
+	int test, dim, words;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		getRandomArray(p, dim);
+		getRandomArray(q, dim);
+		diff = spDistanceL1(p, q, dim) - referenceL1(p, q, dim);
+		ASSERT_TRUE(diff < epsilon && diff > -epsilon);
+		diff = spDistanceInnerProduct(p, q, dim) - referenceInnerProduct(p, q, dim);
+		ASSERT_TRUE(diff < epsilon && diff > -epsilon);
+		words = 1 + rand() % RANDOM_TESTS_WORDS_RANGE;
+		getRandomWords(a, words);
+		getRandomWords(b, words);
+		ASSERT_TRUE(spDistanceHamming(a, b, words) == referenceHamming(a, b, words));
+	}
+	return true;
+}
+
+//checks the half precision conversions of known values, ties and every half value
+bool distanceHalfTest() {
+	double values[6] = { 1.0 , -2.0 , 65504.0 , 70000.0 , 2049.0 , 2051.0 };
+	uint16_t halves[6];
+	uint16_t expected[6] = { 0x3C00 , 0xC000 , 0x7BFF , 0x7C00 , 0x6800 , 0x6802 };
+	uint32_t half;
+	float value;
+	int i;
+	spDistanceToHalf(values, halves, 6);
+	for (i = 0; i < 6; i++) {
+		ASSERT_TRUE(halves[i] == expected[i]);
+		ASSERT_TRUE(spDistanceFloatToHalf((float) values[i]) == expected[i]);
+	}
+	ASSERT_TRUE(spDistanceFloatToHalf(0x1p-24f) == 0x0001); //the minimal subnormal
+	ASSERT_TRUE(spDistanceFloatToHalf(0x1p-26f) == 0x0000);
+	ASSERT_TRUE(spDistanceHalfToFloat(0x0001) == 0x1p-24f);
+	ASSERT_TRUE(spDistanceHalfToFloat(0x3555) == 0x1.554p-2f);
+	for (half = 0; half <= 0xFFFF; half++) {
+		if ((half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0) //NaN
+			continue;
+		value = spDistanceHalfToFloat((uint16_t) half);
+		ASSERT_TRUE(spDistanceFloatToHalf(value) == half);
+	}
+	return true;
+}
+
+//compares the half precision distances to the distances of the rounded coordinates
+bool distanceHalfRandomTest() {
+	double q[RANDOM_TESTS_DIM_RANGE];
+	double p[RANDOM_TESTS_DIM_RANGE];
+	uint16_t rows[3][RANDOM_TESTS_DIM_RANGE];
+	double out[3];
+	double expected, diff;
+	int test, i, row, dim;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		getRandomArray(q, dim);
+		for (row = 0; row < 3; row++) {
+			getRandomArray(p, dim);
+			spDistanceToHalf(p, rows[row], dim);
+			for (i = 0; i < dim; i++) {
+				ASSERT_TRUE(rows[row][i] == spDistanceFloatToHalf((float) p[i]));
+			}
+		}
+		spDistanceL2SquaredHalfStrided(q, rows[0], 3, dim, RANDOM_TESTS_DIM_RANGE, out);
+		for (row = 0; row < 3; row++) {
+			for (i = 0; i < dim; i++) {
+				p[i] = spDistanceHalfToFloat(rows[row][i]);
+			}
+			expected = spDistanceL2Squared(q, p, dim);
+			diff = out[row] - expected;
+			ASSERT_TRUE(diff < 0.001 * expected + epsilon && diff > -0.001 * expected - epsilon);
+		}
+	}
+	return true;
+}
+
+//checks the half precision distances of queries longer than the slab the query is rounded in
+bool distanceHalfLongTest() {
+	static double q[HALF_LONG_TEST_DIM], p[HALF_LONG_TEST_DIM];
+	static uint16_t rows[HALF_LONG_TEST_ROWS][HALF_LONG_TEST_DIM];
+	double out[HALF_LONG_TEST_ROWS];
+	double expected, diff;
+	int i, row, dim = HALF_LONG_TEST_DIM;
+	getRandomArray(q, dim);
+	for (row = 0; row < HALF_LONG_TEST_ROWS; row++) {
+		getRandomArray(p, dim);
+		spDistanceToHalf(p, rows[row], dim);
+	}
+	spDistanceL2SquaredHalfStrided(q, rows[0], HALF_LONG_TEST_ROWS, dim, dim, out);
+	for (row = 0; row < HALF_LONG_TEST_ROWS; row++) {
+		for (i = 0; i < dim; i++) {
+			p[i] = spDistanceHalfToFloat(rows[row][i]);
+		}
+		expected = spDistanceL2Squared(q, p, dim);
+		diff = out[row] - expected;
+		ASSERT_TRUE(diff < 0.001 * expected && diff > -0.001 * expected);
+	}
+	return true;
+}
+
+//checks that the kernels of fixed dimensions compute the distances of the generic kernels
+bool distanceFixedKernelsTest() {
+	int dims[6] = { 2 , 3 , 64 , 128 , 256 , 5 };
+	double q[256];
+	double rows[7 * 256];
+	const double* block[SP_DISTANCE_BLOCK_SIZE];
+	double expected[7], out[7];
+	SPDistanceBlockKernel blockKernel;
+	SPDistanceStridedKernel stridedKernel;
+	int d, i, count;
+	ASSERT_TRUE(spDistanceL2SquaredBlockFor(5) == spDistanceL2SquaredBlock);
+	ASSERT_TRUE(spDistanceL2SquaredStridedFor(5) == spDistanceL2SquaredStrided);
+	for (d = 0; d < 6; d++) {
+		getRandomArray(q, dims[d]);
+		getRandomArray(rows, 7 * 256);
+		blockKernel = spDistanceL2SquaredBlockFor(dims[d]);
+		stridedKernel = spDistanceL2SquaredStridedFor(dims[d]);
+		spDistanceL2SquaredStrided(q, rows, 7, dims[d], 256, expected);
+		stridedKernel(q, rows, 7, dims[d], 256, out);
+		for (i = 0; i < 7; i++) {
+			ASSERT_TRUE(out[i] == expected[i]);
+		}
+		for (count = 1; count <= SP_DISTANCE_BLOCK_SIZE; count++) {
+			for (i = 0; i < count; i++) {
+				block[i] = rows + (6 - i) * 256;
+			}
+			blockKernel(q, block, count, dims[d], out);
+			for (i = 0; i < count; i++) {
+				ASSERT_TRUE(out[i] == expected[6 - i]);
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	srand(0);
+	RUN_TEST(distanceBasicTest);
+	RUN_TEST(distanceCosineTest);
+	RUN_TEST(distanceRandomTest);
+	RUN_TEST(distanceHalfTest);
+	RUN_TEST(distanceHalfRandomTest);
+	RUN_TEST(distanceHalfLongTest);
+	RUN_TEST(distanceFixedKernelsTest);
+	return 0;
+}
@@ -0,0 +1,513 @@
+#include "unit_test_util.h"
+#include "../SPKNNSearch.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define epsilon 0.00001
+#define RANDOM_TESTS_COUNT 30
+#define RANDOM_TESTS_DIM_RANGE 140
+#define RANDOM_TESTS_SIZE_RANGE 600
+#define RANDOM_TESTS_K_RANGE 20
+#define RANDOM_TESTS_QUERIES 11
+
+//used to generate a random point, with coordinates in [offset, offset + 100]
+static SPPoint getRandomPoint(int dim, int index, double offset) {
+	int i;
+	SPPoint p;
+	double* data = (double*)calloc(dim, sizeof(double));
+	for (i = 0; i < dim; i++) {
+		data[i] = offset + ((double)rand() / ((double)RAND_MAX / 100));
+	}
+	p = spPointCreate(data, dim, index);
+	free(data);
+	return p;
+}
+
+//checks that two result queues hold the same neighbours, with values at most maxError apart
+static bool sameResults(SPBPQueue q1, SPBPQueue q2, double maxError) {
+	SPListElement e1, e2;
+	double diff;
+	ASSERT_TRUE(spBPQueueSize(q1) == spBPQueueSize(q2));
+	while (!spBPQueueIsEmpty(q1)) {
+		e1 = spBPQueuePeek(q1);
+		e2 = spBPQueuePeek(q2);
+		diff = spListElementGetValue(e1) - spListElementGetValue(e2);
+		ASSERT_TRUE(diff <= maxError && diff >= -maxError);
+		if (maxError == 0.0) {
+			ASSERT_TRUE(spListElementGetIndex(e1) == spListElementGetIndex(e2));
+		}
+		spListElementDestroy(e1);
+		spListElementDestroy(e2);
+		spBPQueueDequeue(q1);
+		spBPQueueDequeue(q2);
+	}
+	return true;
+}
+
+//checks that the neighbours of a query are the known nearest points
+bool knnSearchBasicTest() {
+	double data[5][2] = { { 0.0 , 0.0 } , { 3.0 , 0.0 } , { 1.0 , 1.0 } , { 0.0 , 2.0 } , { 10.0 , 10.0 } };
+	double queryData[2] = { 0.0 , 0.0 };
+	int expectedIndices[3] = { 10 , 12 , 13 };
+	double expectedValues[3] = { 0.0 , 2.0 , 4.0 };
+	SPPoint points[5];
+	SPPoint query = spPointCreate(queryData, 2, 0);
+	SPBPQueue result = spBPQueueCreate(3);
+	SPPointStore store;
+	SPListElement e;
+	int i, pass;
+	for (i = 0; i < 5; i++) {
+		points[i] = spPointCreate(data[i], 2, 10 + i);
+	}
+	store = spPointStoreCreate(points, 5);
+	for (pass = 0; pass < 2; pass++) {
+		if (pass == 0) {
+			ASSERT_TRUE(spKNNSearch(query, points, 5, result) == SP_KNN_SUCCESS);
+		} else {
+			ASSERT_TRUE(spKNNSearchStore(store, query, result) == SP_KNN_SUCCESS);
+		}
+		ASSERT_TRUE(spBPQueueSize(result) == 3);
+		for (i = 0; i < 3; i++) {
+			e = spBPQueuePeek(result);
+			ASSERT_TRUE(spListElementGetIndex(e) == expectedIndices[i]);
+			ASSERT_TRUE(spListElementGetValue(e) == expectedValues[i]);
+			spListElementDestroy(e);
+			spBPQueueDequeue(result);
+		}
+	}
+	for (i = 0; i < 5; i++) {
+		spPointDestroy(points[i]);
+	}
+	spPointDestroy(query);
+	spPointStoreDestroy(store);
+	spBPQueueDestroy(result);
+	return true;
+}
+
+//checks for correct handling where given invalid arguments
+bool knnSearchInvalidArgumentsTest() {
+	double data[3] = { 1.0 , 2.0 , 3.0 };
+	SPPoint points[2];
+	SPPoint query = spPointCreate(data, 3, 0);
+	SPBPQueue result = spBPQueueCreate(1);
+	SPBPQueue results[1] = { NULL };
+	SPPointStore store;
+	points[0] = spPointCreate(data, 2, 0);
+	points[1] = spPointCreate(data, 3, 1);
+	store = spPointStoreCreate(points, 1);
+	ASSERT_TRUE(spKNNSearch(NULL, points, 2, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearch(query, NULL, 2, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearch(query, points + 1, 1, NULL) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearch(query, points, 2, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearch(query, points, -1, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearch(query, points, 0, result) == SP_KNN_SUCCESS);
+	ASSERT_TRUE(spBPQueueIsEmpty(result));
+	ASSERT_TRUE(spKNNSearchStore(NULL, query, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearchStore(store, query, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearchBatch(store, NULL, SP_KNN_EXACT, results) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearchBatch(store, store, SP_KNN_EXACT, NULL) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearchBatch(store, store, SP_KNN_EXACT, results) == SP_KNN_INVALID_ARGUMENT);
+	spPointDestroy(points[0]);
+	spPointDestroy(points[1]);
+	spPointDestroy(query);
+	spPointStoreDestroy(store);
+	spBPQueueDestroy(result);
+	return true;
+}
+
+//compares the searches over arrays, stores and batches of random points,
+//offset moves the points away from the origin, where the norm decomposition loses precision
+static bool knnSearchRandomTest(double offset) {
+	int test, i, dim, n, k;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPPoint queries[RANDOM_TESTS_QUERIES];
+	SPBPQueue fast[RANDOM_TESTS_QUERIES];
+	SPBPQueue exact[RANDOM_TESTS_QUERIES];
+	SPBPQueue single, stored;
+	SPPointStore store, queryStore;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		n = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		k = 1 + rand() % RANDOM_TESTS_K_RANGE;
+		for (i = 0; i < n; i++) {
+			points[i] = getRandomPoint(dim, i, offset);
+		}
+		for (i = 0; i < RANDOM_TESTS_QUERIES; i++) {
+			queries[i] = getRandomPoint(dim, i, offset);
+			fast[i] = spBPQueueCreate(k);
+			exact[i] = spBPQueueCreate(k);
+		}
+		store = spPointStoreCreate(points, n);
+		queryStore = spPointStoreCreate(queries, RANDOM_TESTS_QUERIES);
+		single = spBPQueueCreate(k);
+		stored = spBPQueueCreate(k);
+		ASSERT_TRUE(spKNNSearchBatch(store, queryStore, SP_KNN_FAST, fast) == SP_KNN_SUCCESS);
+		ASSERT_TRUE(spKNNSearchBatch(store, queryStore, SP_KNN_EXACT, exact) == SP_KNN_SUCCESS);
+		for (i = 0; i < RANDOM_TESTS_QUERIES; i++) {
+			ASSERT_TRUE(spKNNSearch(queries[i], points, n, single) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(spKNNSearchStore(store, queries[i], stored) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(spBPQueueSize(single) == (k < n ? k : n));
+			ASSERT_TRUE(sameResults(single, stored, 0.0));
+			ASSERT_TRUE(spKNNSearchStore(store, queries[i], stored) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(sameResults(exact[i], stored, 0.0));
+			if (offset == 0.0) {
+				ASSERT_TRUE(spKNNSearchStore(store, queries[i], stored) == SP_KNN_SUCCESS);
+				ASSERT_TRUE(sameResults(fast[i], stored, epsilon));
+			}
+			spPointDestroy(queries[i]);
+			spBPQueueDestroy(fast[i]);
+			spBPQueueDestroy(exact[i]);
+		}
+		for (i = 0; i < n; i++) {
+			spPointDestroy(points[i]);
+		}
+		spPointStoreDestroy(store);
+		spPointStoreDestroy(queryStore);
+		spBPQueueDestroy(single);
+		spBPQueueDestroy(stored);
+	}
+	return true;
+}
+
+//compares the searches for points around the origin
+bool knnSearchRandomPointsTest() {
+	return knnSearchRandomTest(0.0);
+}
+
+//compares the searches for points far from the origin, where only the exact batch is exact
+bool knnSearchFarPointsTest() {
+	return knnSearchRandomTest(1e7);
+}
+
+//compares the searches for points on spheres of different radii around the origin,
+//most of which are pruned by their norms
+bool knnSearchSpheresTest() {
+	int test, i, j, dim, n, k;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPPoint query;
+	SPPointStore store, queryStore;
+	SPBPQueue single, stored, exact;
+	double length;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 16 + rand() % RANDOM_TESTS_DIM_RANGE;
+		n = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		k = 1 + rand() % RANDOM_TESTS_K_RANGE;
+		for (i = 0; i <= n; i++) {
+			//point i lies on the sphere of radius 1 + i % 50
+			SPPoint p = getRandomPoint(dim, i, -50.0);
+			double* data = (double*)malloc(dim * sizeof(double));
+			length = 0.0;
+			for (j = 0; j < dim; j++) {
+				data[j] = spPointGetAxisCoor(p, j);
+				length += data[j] * data[j];
+			}
+			for (j = 0; j < dim; j++) {
+				data[j] *= (1 + i % 50) / sqrt(length);
+			}
+			spPointDestroy(p);
+			if (i < n) {
+				points[i] = spPointCreate(data, dim, i);
+			} else {
+				query = spPointCreate(data, dim, 0);
+			}
+			free(data);
+		}
+		store = spPointStoreCreate(points, n);
+		queryStore = spPointStoreCreate(&query, 1);
+		single = spBPQueueCreate(k);
+		stored = spBPQueueCreate(k);
+		exact = spBPQueueCreate(k);
+		ASSERT_TRUE(spKNNSearch(query, points, n, single) == SP_KNN_SUCCESS);
+		ASSERT_TRUE(spKNNSearchStore(store, query, stored) == SP_KNN_SUCCESS);
+		ASSERT_TRUE(spKNNSearchBatch(store, queryStore, SP_KNN_EXACT, &exact) == SP_KNN_SUCCESS);
+		ASSERT_TRUE(spBPQueueSize(single) == (k < n ? k : n));
+		ASSERT_TRUE(sameResults(single, exact, 0.0));
+		ASSERT_TRUE(spKNNSearchBatch(store, queryStore, SP_KNN_EXACT, &exact) == SP_KNN_SUCCESS);
+		ASSERT_TRUE(sameResults(stored, exact, 0.0));
+		for (i = 0; i < n; i++) {
+			spPointDestroy(points[i]);
+		}
+		spPointDestroy(query);
+		spPointStoreDestroy(store);
+		spPointStoreDestroy(queryStore);
+		spBPQueueDestroy(single);
+		spBPQueueDestroy(stored);
+		spBPQueueDestroy(exact);
+	}
+	return true;
+}
+
+//checks the neighbours of a query by every metric over arrays and stores
+bool knnSearchMetricTest() {
+	double data[5][2] = { { 2.0 , 1.0 } , { 0.0 , 3.0 } , { -2.0 , 0.0 } , { 4.0 , 1.0 } , { 2.0 , 2.0 } };
+	double queryData[2] = { 1.0 , 1.0 };
+	SP_KNN_METRIC metrics[4] = { SP_KNN_L2_SQUARED , SP_KNN_L1 , SP_KNN_INNER_PRODUCT , SP_KNN_COSINE };
+	//the expected neighbours by every metric, nearest first
+	int expectedIndices[4][3] = { { 0 , 4 , 1 } , { 0 , 4 , 1 } , { 3 , 4 , 0 } , { 4 , 0 , 3 } };
+	double expectedValues[4][3] = { { 1.0 , 2.0 , 5.0 } , { 1.0 , 2.0 , 3.0 } ,
+			{ sqrt(34.0) - 5.0 , sqrt(34.0) - 4.0 , sqrt(34.0) - 3.0 } ,
+			{ 0.0 , 1.0 - 3.0 / sqrt(10.0) , 1.0 - 5.0 / sqrt(34.0) } };
+	SPPoint points[5];
+	SPPoint query = spPointCreate(queryData, 2, 0);
+	SPBPQueue result = spBPQueueCreate(3);
+	SPPointStore store;
+	SPListElement e;
+	double diff;
+	int i, m, pass;
+	for (i = 0; i < 5; i++) {
+		points[i] = spPointCreate(data[i], 2, i);
+	}
+	store = spPointStoreCreate(points, 5);
+	for (m = 0; m < 4; m++) {
+		for (pass = 0; pass < 2; pass++) {
+			if (pass == 0) {
+				ASSERT_TRUE(spKNNSearchMetric(query, points, 5, metrics[m], result) == SP_KNN_SUCCESS);
+			} else {
+				ASSERT_TRUE(spKNNSearchStoreMetric(store, query, metrics[m], result) == SP_KNN_SUCCESS);
+			}
+			ASSERT_TRUE(spBPQueueSize(result) == 3);
+			for (i = 0; i < 3; i++) {
+				e = spBPQueuePeek(result);
+				diff = spListElementGetValue(e) - expectedValues[m][i];
+				ASSERT_TRUE(spListElementGetIndex(e) == expectedIndices[m][i]);
+				ASSERT_TRUE(diff < epsilon && diff > -epsilon);
+				spListElementDestroy(e);
+				spBPQueueDequeue(result);
+			}
+		}
+	}
+	ASSERT_TRUE(spKNNSearchMetric(query, points, 5, (SP_KNN_METRIC) 7, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearchStoreMetric(store, query, (SP_KNN_METRIC) 7, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearchMetric(query, NULL, 5, SP_KNN_COSINE, result) == SP_KNN_INVALID_ARGUMENT);
+	ASSERT_TRUE(spKNNSearchStoreMetric(NULL, query, SP_KNN_L1, result) == SP_KNN_INVALID_ARGUMENT);
+	for (i = 0; i < 5; i++) {
+		spPointDestroy(points[i]);
+	}
+	spPointDestroy(query);
+	spPointStoreDestroy(store);
+	spBPQueueDestroy(result);
+	return true;
+}
+
+//compares the binary search to the Hamming distances of all the random binary points
+bool knnSearchBinaryTest() {
+	uint64_t words[4];
+	SPBinaryPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPBinaryPoint query, other;
+	SPBPQueue result, expected;
+	SPListElement e;
+	int test, i, j, n, k;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		n = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		k = 1 + rand() % RANDOM_TESTS_K_RANGE;
+		for (i = 0; i <= n; i++) {
+			for (j = 0; j < 4; j++) {
+				words[j] = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+			}
+			if (i < n) {
+				points[i] = spBinaryPointCreate(words, 256, i);
+			} else {
+				query = spBinaryPointCreate(words, 256, 0);
+			}
+		}
+		result = spBPQueueCreate(k);
+		expected = spBPQueueCreate(k);
+		ASSERT_TRUE(spKNNSearchBinary(query, points, n, result) == SP_KNN_SUCCESS);
+		for (i = 0; i < n; i++) {
+			e = spListElementCreate(i, spBinaryPointHammingDistance(query, points[i]));
+			spBPQueueEnqueue(expected, e);
+			spListElementDestroy(e);
+		}
+		ASSERT_TRUE(spBPQueueSize(result) == (k < n ? k : n));
+		ASSERT_TRUE(sameResults(result, expected, 0.0));
+		other = spBinaryPointCreate(words, 128, 0);
+		ASSERT_TRUE(spKNNSearchBinary(other, points, n, result) == SP_KNN_INVALID_ARGUMENT);
+		ASSERT_TRUE(spKNNSearchBinary(query, NULL, n, result) == SP_KNN_INVALID_ARGUMENT);
+		ASSERT_TRUE(spKNNSearchBinary(query, points, n, NULL) == SP_KNN_INVALID_ARGUMENT);
+		for (i = 0; i < n; i++) {
+			spBinaryPointDestroy(points[i]);
+		}
+		spBinaryPointDestroy(query);
+		spBinaryPointDestroy(other);
+		spBPQueueDestroy(result);
+		spBPQueueDestroy(expected);
+	}
+	return true;
+}
+
+//checks the searches of half precision stores of exactly representable coordinates
+bool knnSearchHalfTest() {
+	int test, i, j, dim, n, k;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPPoint queries[RANDOM_TESTS_QUERIES];
+	SPBPQueue expected[RANDOM_TESTS_QUERIES];
+	SPBPQueue results[RANDOM_TESTS_QUERIES];
+	SPBPQueue result;
+	double data[RANDOM_TESTS_DIM_RANGE];
+	SPPointStore store, halfStore, halfQueries;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		n = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		k = 1 + rand() % RANDOM_TESTS_K_RANGE;
+		for (i = 0; i < n + RANDOM_TESTS_QUERIES; i++) {
+			for (j = 0; j < dim; j++) {
+				data[j] = (double) (rand() % 9 - 4);
+			}
+			if (i < n) {
+				points[i] = spPointCreate(data, dim, i);
+			} else {
+				queries[i - n] = spPointCreate(data, dim, 0);
+			}
+		}
+		store = spPointStoreCreate(points, n);
+		halfStore = spPointStoreCreateWithPrecision(points, n, SP_POINT_STORE_HALF);
+		halfQueries = spPointStoreCreateWithPrecision(queries, RANDOM_TESTS_QUERIES, SP_POINT_STORE_HALF);
+		result = spBPQueueCreate(k);
+		for (i = 0; i < RANDOM_TESTS_QUERIES; i++) {
+			expected[i] = spBPQueueCreate(k);
+			results[i] = spBPQueueCreate(k);
+		}
+		ASSERT_TRUE(spKNNSearchBatch(halfStore, halfQueries, SP_KNN_FAST, results) == SP_KNN_SUCCESS);
+		for (i = 0; i < RANDOM_TESTS_QUERIES; i++) {
+			ASSERT_TRUE(spKNNSearchStore(store, queries[i], expected[i]) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(spKNNSearchStore(halfStore, queries[i], result) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(sameResults(result, results[i], 0.0));
+			ASSERT_TRUE(spKNNSearchStore(halfStore, queries[i], result) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(sameResults(result, expected[i], 0.0));
+			ASSERT_TRUE(spKNNSearchStoreMetric(store, queries[i], SP_KNN_L1, expected[i]) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(spKNNSearchStoreMetric(halfStore, queries[i], SP_KNN_L1, result) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(sameResults(result, expected[i], 0.0));
+		}
+		for (i = 0; i < n; i++) {
+			spPointDestroy(points[i]);
+		}
+		for (i = 0; i < RANDOM_TESTS_QUERIES; i++) {
+			spPointDestroy(queries[i]);
+			spBPQueueDestroy(expected[i]);
+			spBPQueueDestroy(results[i]);
+		}
+		spPointStoreDestroy(store);
+		spPointStoreDestroy(halfStore);
+		spPointStoreDestroy(halfQueries);
+		spBPQueueDestroy(result);
+	}
+	return true;
+}
+
+//compares the searches of k <= 2 neighbours, which do not fill the queue during the
+//search, to the queue of all the distances, for points with many equal distances
+bool knnSearchNearestTest() {
+	int test, i, j, dim, n, k;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPPoint query = NULL;
+	SPBPQueue result, expected;
+	SPPointStore store, halfStore;
+	SPListElement e;
+	double data[RANDOM_TESTS_DIM_RANGE];
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		n = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		k = test % 3;
+		for (i = 0; i <= n; i++) {
+			for (j = 0; j < dim; j++) {
+				data[j] = (double) (rand() % 3 - 1);
+			}
+			if (i < n) {
+				//the indices decrease, so equal distances are found in the reverse order
+				points[i] = spPointCreate(data, dim, n - i);
+			} else {
+				query = spPointCreate(data, dim, 0);
+			}
+		}
+		store = spPointStoreCreate(points, n);
+		halfStore = spPointStoreCreateWithPrecision(points, n, SP_POINT_STORE_HALF);
+		result = spBPQueueCreate(k);
+		expected = spBPQueueCreateWithBackend(k, SP_BPQUEUE_LIST);
+		for (j = 0; j < 3; j++) {
+			for (i = 0; i < n; i++) {
+				e = spListElementCreate(n - i, spPointL2SquaredDistance(query, points[i]));
+				spBPQueueEnqueue(expected, e);
+				spListElementDestroy(e);
+			}
+			if (j == 0) {
+				ASSERT_TRUE(spKNNSearch(query, points, n, result) == SP_KNN_SUCCESS);
+			} else {
+				ASSERT_TRUE(spKNNSearchStore(j == 1 ? store : halfStore, query, result) == SP_KNN_SUCCESS);
+			}
+			ASSERT_TRUE(spBPQueueSize(result) == (k < n ? k : n));
+			ASSERT_TRUE(sameResults(result, expected, 0.0));
+		}
+		for (i = 0; i < n; i++) {
+			spPointDestroy(points[i]);
+		}
+		spPointDestroy(query);
+		spPointStoreDestroy(store);
+		spPointStoreDestroy(halfStore);
+		spBPQueueDestroy(result);
+		spBPQueueDestroy(expected);
+	}
+	return true;
+}
+
+//compares the searches with result queues of every backend, which the searches read
+//after every accepted neighbour, to the searches with the list backend
+bool knnSearchQueueBackendsTest() {
+	SP_BPQUEUE_BACKEND backends[3] = { SP_BPQUEUE_MIN_MAX_HEAP , SP_BPQUEUE_SORTED_ARRAY ,
+			SP_BPQUEUE_LAZY };
+	int test, i, b, dim, n, k;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPPoint query = NULL;
+	SPPointStore store;
+	SPBPQueue result, expected;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		n = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		//up to more neighbours than points, past the k <= 2 searches
+		k = 3 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		for (i = 0; i <= n; i++) {
+			if (i < n) {
+				points[i] = getRandomPoint(dim, i, 0.0);
+			} else {
+				query = getRandomPoint(dim, 0, 0.0);
+			}
+		}
+		store = spPointStoreCreate(points, n);
+		expected = spBPQueueCreateWithBackend(k, SP_BPQUEUE_LIST);
+		for (b = 0; b < 3; b++) {
+			result = spBPQueueCreateWithBackend(k, backends[b]);
+			ASSERT_TRUE(spKNNSearch(query, points, n, expected) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(spKNNSearch(query, points, n, result) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(spBPQueueSize(result) == (k < n ? k : n));
+			ASSERT_TRUE(sameResults(result, expected, 0.0));
+			ASSERT_TRUE(spKNNSearchStore(store, query, expected) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(spKNNSearchStore(store, query, result) == SP_KNN_SUCCESS);
+			ASSERT_TRUE(sameResults(result, expected, 0.0));
+			spBPQueueDestroy(result);
+		}
+		for (i = 0; i < n; i++) {
+			spPointDestroy(points[i]);
+		}
+		spPointDestroy(query);
+		spPointStoreDestroy(store);
+		spBPQueueDestroy(expected);
+	}
+	return true;
+}
+
+int main() {
+	srand(0);
+	RUN_TEST(knnSearchBasicTest);
+	RUN_TEST(knnSearchInvalidArgumentsTest);
+	RUN_TEST(knnSearchRandomPointsTest);
+	RUN_TEST(knnSearchFarPointsTest);
+	RUN_TEST(knnSearchSpheresTest);
+	RUN_TEST(knnSearchMetricTest);
+	RUN_TEST(knnSearchBinaryTest);
+	RUN_TEST(knnSearchHalfTest);
+	RUN_TEST(knnSearchNearestTest);
+	RUN_TEST(knnSearchQueueBackendsTest);
+	return 0;
+}
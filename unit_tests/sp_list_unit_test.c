@@ -6,6 +6,10 @@
 #include <string.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <stdint.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
 
 static SPList quickList(int size, ...) {
 	int i;
@@ -45,6 +49,44 @@ static bool testElementCompare() {
 	return true;
 }
 
+//checks that the keys of elements are ordered as the elements, for values which
+//round to the same float, to floats close to them and beyond the range of floats
+static bool testElementKey() {
+	double values[9] = { 0.0, DBL_MIN, 1.0, 1.0 + DBL_EPSILON, 1.0 + FLT_EPSILON, 3.5, FLT_MAX,
+			1e300, INFINITY };
+	int indices[3] = { 0, 7, INT_MAX };
+	SPListElement elements[27];
+	uint64_t key1, key2;
+	int i, j, order;
+	for (i = 0; i < 27; i++) {
+		elements[i] = spListElementCreate(indices[i % 3], values[i / 3]);
+	}
+	ASSERT_TRUE(spListElementGetKey(elements[0]) == 0);
+	ASSERT_TRUE(spListElementGetKey(elements[5]) == (uint64_t) INT_MAX);
+	for (i = 0; i < 27; i++) {
+		for (j = 0; j < 27; j++) {
+			key1 = spListElementGetKey(elements[i]);
+			key2 = spListElementGetKey(elements[j]);
+			order = spListElementCompare(elements[i], elements[j]);
+			ASSERT_TRUE(order == -1 || order == 0 || order == 1);
+			if (order < 0) {
+				ASSERT_TRUE(key1 >> 32 <= key2 >> 32);
+			}
+			if (key1 >> 32 != key2 >> 32) {
+				ASSERT_TRUE((key1 < key2) == (order < 0));
+			}
+		}
+	}
+	//1.0 + DBL_EPSILON rounds to the float 1.0, 1e300 and infinity share FLT_MAX
+	ASSERT_TRUE(spListElementGetKey(elements[6]) == spListElementGetKey(elements[9]));
+	ASSERT_TRUE(spListElementCompare(elements[6], elements[9]) < 0);
+	ASSERT_TRUE(spListElementGetKey(elements[18]) == spListElementGetKey(elements[24]));
+	for (i = 0; i < 27; i++) {
+		spListElementDestroy(elements[i]);
+	}
+	return true;
+}
+
 static bool testElementGetIndex() {
 	SPListElement element1 = spListElementCreate(1, 0.0);
 	SPListElement element2 = spListElementCreate(2, 0.0);
@@ -348,6 +390,7 @@ int main() {
 	RUN_TEST(testElementCreate);
 	RUN_TEST(testElementCopy);
 	RUN_TEST(testElementCompare);
+	RUN_TEST(testElementKey);
 	RUN_TEST(testElementGetIndex);
 	RUN_TEST(testIsElementGetValue);
 	RUN_TEST(testElementSetIndex);
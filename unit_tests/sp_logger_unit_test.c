@@ -160,6 +160,243 @@ static bool basicLoggerLinesTest() {
 	return true;
 }
 
+//Prints the same records used by the segmented logger tests
+static bool printSegmentedRecords() {
+	ASSERT_TRUE(spLoggerPrintError("MSGA", "sp_logger_unit_test.c", "printSegmentedRecords", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB", "sp_logger_unit_test.c", "printSegmentedRecords", 2) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintDebug("MSGD", "sp_logger_unit_test.c", "printSegmentedRecords", 3) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg("PrintMsg1") == SP_LOGGER_SUCCESS);
+	return true;
+}
+
+//Segmented output should be identical to the regular file output
+static bool segmentedLoggerOutputTest() {
+	const char* expectedFile = "segmentedLoggerOutputTestExp.log";
+	const char* testFile = "segmentedLoggerOutputTest.log";
+	ASSERT_TRUE(spLoggerCreate(expectedFile, SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(printSegmentedRecords());
+	spLoggerDestroy();
+	remove(testFile);
+	ASSERT_TRUE(spLoggerCreateSegmented(testFile, SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL, 4096, 2) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(printSegmentedRecords());
+	spLoggerDestroy();
+	ASSERT_TRUE(identicalFiles(testFile,expectedFile));
+	return true;
+}
+
+//Reads a segment file, and checks it holds count whole copies of record
+static bool isSegmentOf(const char* fname, const char* record, int count) {
+	char content[256];
+	size_t length = 0, i;
+	FILE* fp = fopen(fname, "r");
+	if (fp == NULL) {
+		return false;
+	}
+	while (record[length] != '\0') {
+		length++;
+	}
+	if (fread(content, 1, sizeof(content), fp) != length * (size_t) count) {
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+	for (i = 0; i < length * (size_t) count; i++) {
+		if (content[i] != record[i % length]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//Segments are rotated before a record which does not fit, and only the last segments are kept
+static bool segmentedLoggerRotationTest() {
+	const char* testFile = "segmentedLoggerRotationTest.log";
+	char name[64];
+	char longRecord[150];
+	int i;
+	ASSERT_TRUE(spLoggerCreateSegmented(testFile, SP_LOGGER_ERROR_LEVEL, 64, 3) == SP_LOGGER_SUCCESS);
+	for (i = 0; i < 100; i++) {
+		ASSERT_TRUE(spLoggerPrintMsg("0123456789") == SP_LOGGER_SUCCESS);
+	}
+	spLoggerDestroy();
+
+	//5 records of 11 bytes fit a segment of 64 bytes, the 100 records fill 20 segments
+	ASSERT_TRUE(isSegmentOf(testFile, "0123456789\n", 5));
+	for (i = 1; i < 3; i++) {
+		sprintf(name, "%s.%d", testFile, i);
+		ASSERT_TRUE(isSegmentOf(name, "0123456789\n", 5));
+		remove(name);
+	}
+	sprintf(name, "%s.%d", testFile, 3);
+	ASSERT_TRUE(fopen(name, "r") == NULL);
+	remove(testFile);
+
+	//only a record longer than a segment is split, from the space left in the active segment
+	for (i = 0; i < 149; i++) {
+		longRecord[i] = 'x';
+	}
+	longRecord[149] = '\0';
+	ASSERT_TRUE(spLoggerCreateSegmented(testFile, SP_LOGGER_ERROR_LEVEL, 64, 4) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg("0123456789") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg(longRecord) == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+	sprintf(name, "%s.%d", testFile, 2);
+	ASSERT_TRUE(isSegmentOf(name, "0123456789\nxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", 1));
+	remove(name);
+	sprintf(name, "%s.%d", testFile, 1);
+	ASSERT_TRUE(isSegmentOf(name, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", 1));
+	remove(name);
+	ASSERT_TRUE(isSegmentOf(testFile, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\n", 1));
+	sprintf(name, "%s.%d", testFile, 3);
+	ASSERT_TRUE(fopen(name, "r") == NULL);
+	remove(testFile);
+	return true;
+}
+
+//Check invalid arguments and double definition of the segmented logger
+static bool segmentedLoggerInvalidArgumentsTest() {
+	const char* testFile = "segmentedLoggerInvalidArgumentsTest.log";
+	ASSERT_TRUE(spLoggerCreateSegmented(NULL, SP_LOGGER_ERROR_LEVEL, 64, 3) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerCreateSegmented(testFile, SP_LOGGER_ERROR_LEVEL, 0, 3) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerCreateSegmented(testFile, SP_LOGGER_ERROR_LEVEL, 64, 0) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerCreateSegmented(testFile, SP_LOGGER_ERROR_LEVEL, 64, 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerCreateSegmented(testFile, SP_LOGGER_ERROR_LEVEL, 64, 1) == SP_LOGGER_DEFINED);
+	ASSERT_TRUE(spLoggerCreate(testFile, SP_LOGGER_ERROR_LEVEL) == SP_LOGGER_DEFINED);
+	spLoggerDestroy();
+	remove(testFile);
+	return true;
+}
+
+//Only one of every 3 records of a call site should be printed, the suppressed counts
+//are due only every 10 seconds and are printed when the logger is destroyed
+static bool sampledLoggerTest() {
+	const char* expectedFile = "sampledLoggerTestExp.log";
+	const char* testFile = "sampledLoggerTest.log";
+	int i;
+	ASSERT_TRUE(spLoggerCreate(expectedFile, SP_LOGGER_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB", "sp_logger_unit_test.c", "sampledLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB", "sp_logger_unit_test.c", "sampledLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB", "sp_logger_unit_test.c", "sampledLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg("PrintMsg1") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("suppressed 4 messages", "sp_logger_unit_test.c", "sampledLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("suppressed 1 messages") == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+
+	ASSERT_TRUE(spLoggerCreate(testFile, SP_LOGGER_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetSampling(0) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerSetSampling(3) == SP_LOGGER_SUCCESS);
+	for (i = 0; i < 7; i++) {
+		ASSERT_TRUE(spLoggerPrintWarning("MSGB", "sp_logger_unit_test.c", "sampledLoggerTest", 1) == SP_LOGGER_SUCCESS);
+		if (i < 2) {
+			ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+		}
+	}
+	ASSERT_TRUE(spLoggerPrintMsg("PrintMsg1") == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+	ASSERT_TRUE(identicalFiles(testFile,expectedFile));
+	return true;
+}
+
+//Only burst records of a call site should be printed when the rate is negligible
+static bool rateLimitedLoggerTest() {
+	const char* expectedFile = "rateLimitedLoggerTestExp.log";
+	const char* testFile = "rateLimitedLoggerTest.log";
+	int i;
+	ASSERT_TRUE(spLoggerCreate(expectedFile, SP_LOGGER_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError("MSGA", "sp_logger_unit_test.c", "rateLimitedLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError("MSGA", "sp_logger_unit_test.c", "rateLimitedLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError("MSGA", "sp_logger_unit_test.c", "rateLimitedLoggerTest", 2) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError("suppressed 3 messages", "sp_logger_unit_test.c", "rateLimitedLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+
+	ASSERT_TRUE(spLoggerCreate(testFile, SP_LOGGER_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetRateLimit(-1, 2) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerSetRateLimit(1e-9, 0) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerSetRateLimit(1e-9, 2) == SP_LOGGER_SUCCESS);
+	for (i = 0; i < 5; i++) {
+		ASSERT_TRUE(spLoggerPrintError("MSGA", "sp_logger_unit_test.c", "rateLimitedLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	}
+	ASSERT_TRUE(spLoggerPrintError("MSGA", "sp_logger_unit_test.c", "rateLimitedLoggerTest", 2) == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+	ASSERT_TRUE(identicalFiles(testFile,expectedFile));
+	ASSERT_TRUE(spLoggerSetRateLimit(1, 1) == SP_LOGGER_UNDIFINED);
+	ASSERT_TRUE(spLoggerSetSampling(1) == SP_LOGGER_UNDIFINED);
+	return true;
+}
+
+//Reads the timestamp printed in the given line of a log file
+static bool readTimestamp(const char* fname, int lineNumber, double* timestamp) {
+	char line[256];
+	int i;
+	FILE* fp = fopen(fname, "r");
+	if (fp == NULL) {
+		return false;
+	}
+	for (i = 0; i < lineNumber; i++) {
+		if (fgets(line, sizeof(line), fp) == NULL) {
+			fclose(fp);
+			return false;
+		}
+	}
+	fclose(fp);
+	return sscanf(line, "- time: %lf", timestamp) == 1;
+}
+
+//Records should carry a wall-clock timestamp once timestamps are set
+static bool timestampLoggerTest() {
+	const char* testFile = "timestampLoggerTest.log";
+	double first, second;
+	ASSERT_TRUE(spLoggerSetTimestamps(SP_LOGGER_TIMESTAMP_PRECISE) == SP_LOGGER_UNDIFINED);
+	ASSERT_TRUE(spLoggerCreate(testFile, SP_LOGGER_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetTimestamps((SP_LOGGER_TIMESTAMP) 17) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerSetTimestamps(SP_LOGGER_TIMESTAMP_PRECISE) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError("MSGA", "sp_logger_unit_test.c", "timestampLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetTimestamps(SP_LOGGER_TIMESTAMP_COARSE) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg("PrintMsg1") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetTimestamps(SP_LOGGER_TIMESTAMP_NONE) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+
+	ASSERT_TRUE(readTimestamp(testFile, 2, &first));
+	ASSERT_TRUE(first > 1e9); //wall-clock time, not the time since boot
+	ASSERT_TRUE(readTimestamp(testFile, 8, &second));
+	ASSERT_TRUE(second > first - 1 && second < first + 1);
+	ASSERT_FALSE(readTimestamp(testFile, 12, &second));
+	return true;
+}
+
+//Info records of different messages are limited separately, and the suppressed
+//counts are printed when the sampling is set again
+static bool callSiteLoggerTest() {
+	const char* expectedFile = "callSiteLoggerTestExp.log";
+	const char* testFile = "callSiteLoggerTest.log";
+	int i;
+	ASSERT_TRUE(spLoggerCreate(expectedFile, SP_LOGGER_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	for (i = 0; i < 2; i++) {
+		ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+		ASSERT_TRUE(spLoggerPrintInfo("MSGD") == SP_LOGGER_SUCCESS);
+	}
+	ASSERT_TRUE(spLoggerPrintInfo("suppressed 1 messages") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("suppressed 1 messages") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB", "sp_logger_unit_test.c", "callSiteLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+
+	ASSERT_TRUE(spLoggerCreate(testFile, SP_LOGGER_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetSampling(2) == SP_LOGGER_SUCCESS);
+	for (i = 0; i < 3; i++) {
+		ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+		ASSERT_TRUE(spLoggerPrintInfo("MSGD") == SP_LOGGER_SUCCESS);
+	}
+	ASSERT_TRUE(spLoggerSetSampling(1) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB", "sp_logger_unit_test.c", "callSiteLoggerTest", 1) == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+	ASSERT_TRUE(identicalFiles(testFile,expectedFile));
+	return true;
+}
+
 int main() {
 	RUN_TEST(basicLoggerTest);
 	RUN_TEST(basicLoggerErrorTest);
@@ -170,6 +407,13 @@ int main() {
 	RUN_TEST(basicLoggerInvalidArgumentsTest);
 	RUN_TEST(basicLoggerPrintMsgTest);
 	RUN_TEST(basicLoggerLinesTest);
+	RUN_TEST(segmentedLoggerOutputTest);
+	RUN_TEST(segmentedLoggerRotationTest);
+	RUN_TEST(segmentedLoggerInvalidArgumentsTest);
+	RUN_TEST(sampledLoggerTest);
+	RUN_TEST(rateLimitedLoggerTest);
+	RUN_TEST(timestampLoggerTest);
+	RUN_TEST(callSiteLoggerTest);
 	return 0;
 }
 
@@ -0,0 +1,209 @@
+#include "unit_test_util.h"
+#include "../SPPoint.h"
+#include "../SPPointStore.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define epsilon 0.00001
+#define RANDOM_TESTS_COUNT 100
+#define RANDOM_TESTS_DIM_RANGE 150
+#define RANDOM_TESTS_SIZE_RANGE 40
+
+//used to generate a random point
+SPPoint getRandomPoint(int dim, int index) {
+	int i;
+	SPPoint p;
+	double* data = (double*)calloc(dim, sizeof(double));
+	for (i = 0; i < dim; i++) {
+		data[i] = ((double)rand() / ((double)RAND_MAX / 100));
+	}
+	p = spPointCreate(data, dim, index);
+	free(data);
+	return p;
+}
+
+//checks that the store holds copies of the given points
+bool pointStoreCreateTest() {
+	int i, j;
+	double data[3][3] = { { 1.0 , 2.0 , 3.0 } , { 4.0 , 5.0 , 6.0 } , { 7.0 , 8.0 , 9.0 } };
+	SPPoint points[3];
+	SPPointStore store;
+	for (i = 0; i < 3; i++) {
+		points[i] = spPointCreate(data[i], 3, 10 - i);
+	}
+	store = spPointStoreCreate(points, 3);
+	for (i = 0; i < 3; i++) {
+		spPointDestroy(points[i]);
+	}
+	ASSERT_TRUE(store != NULL);
+	ASSERT_TRUE(spPointStoreGetSize(store) == 3);
+	ASSERT_TRUE(spPointStoreGetDimension(store) == 3);
+	for (i = 0; i < 3; i++) {
+		ASSERT_TRUE(spPointStoreGetIndex(store, i) == 10 - i);
+		ASSERT_TRUE(spPointStoreGetSquaredNorm(store, i)
+				== data[i][0] * data[i][0] + data[i][1] * data[i][1] + data[i][2] * data[i][2]);
+		for (j = 0; j < 3; j++) {
+			ASSERT_TRUE(spPointStoreGetAxisCoor(store, i, j) == data[i][j]);
+		}
+	}
+	spPointStoreDestroy(store);
+	return true;
+}
+
+//checks for correct handling where given invalid arguments
+bool pointStoreCreateInvalidArgumentsTest() {
+	double data[3] = { 1.0 , 2.0 , 3.0 };
+	SPPoint points[2];
+	points[0] = spPointCreate(data, 3, 0);
+	points[1] = spPointCreate(data, 2, 1);
+	ASSERT_TRUE(spPointStoreCreate(NULL, 2) == NULL);
+	ASSERT_TRUE(spPointStoreCreate(points, 0) == NULL);
+	ASSERT_TRUE(spPointStoreCreate(points, 2) == NULL); //different dimensions
+	spPointDestroy(points[1]);
+	points[1] = NULL;
+	ASSERT_TRUE(spPointStoreCreate(points, 2) == NULL);
+	spPointDestroy(points[0]);
+	spPointStoreDestroy(NULL);
+	return true;
+}
+
+//checks that the distances of the store match the pairwise distances
+bool pointStoreL2SquaredDistanceManyTest() {
+	int test, i, dim, size;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	double out[RANDOM_TESTS_SIZE_RANGE];
+	SPPointStore store;
+	SPPoint q;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		size = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		for (i = 0; i < size; i++) {
+			points[i] = getRandomPoint(dim, i);
+		}
+		q = getRandomPoint(dim, 0);
+		store = spPointStoreCreate(points, size);
+		ASSERT_TRUE(store != NULL);
+		spPointStoreL2SquaredDistanceMany(store, q, out);
+		for (i = 0; i < size; i++) {
+			ASSERT_TRUE(out[i] - spPointL2SquaredDistance(q, points[i]) < epsilon
+					&& out[i] - spPointL2SquaredDistance(q, points[i]) > -epsilon);
+			spPointDestroy(points[i]);
+		}
+		spPointStoreDestroy(store);
+		spPointDestroy(q);
+	}
+	return true;
+}
+
+//checks that the distance matrix matches the pairwise distances
+bool pointStoreL2SquaredDistanceMatrixTest() {
+	int test, i, j, dim, size, queriesSize, first;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPPoint queries[RANDOM_TESTS_SIZE_RANGE];
+	double out[RANDOM_TESTS_SIZE_RANGE * RANDOM_TESTS_SIZE_RANGE];
+	double expected;
+	SPPointStore store, queryStore;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		size = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		queriesSize = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		first = rand() % queriesSize;
+		for (i = 0; i < size; i++) {
+			points[i] = getRandomPoint(dim, i);
+		}
+		for (i = 0; i < queriesSize; i++) {
+			queries[i] = getRandomPoint(dim, i);
+		}
+		store = spPointStoreCreate(points, size);
+		queryStore = spPointStoreCreate(queries, queriesSize);
+		ASSERT_TRUE(store != NULL && queryStore != NULL);
+		ASSERT_TRUE(spPointStoreL2SquaredDistanceMatrix(queryStore, first, queriesSize - first, store, out));
+		for (i = first; i < queriesSize; i++) {
+			for (j = 0; j < size; j++) {
+				expected = spPointL2SquaredDistance(queries[i], points[j]);
+				ASSERT_TRUE(out[(i - first) * size + j] - expected < epsilon
+						&& out[(i - first) * size + j] - expected > -epsilon);
+			}
+		}
+		for (i = 0; i < size; i++) {
+			spPointDestroy(points[i]);
+		}
+		for (i = 0; i < queriesSize; i++) {
+			spPointDestroy(queries[i]);
+		}
+		spPointStoreDestroy(store);
+		spPointStoreDestroy(queryStore);
+	}
+	return true;
+}
+
+//checks a half precision store of exactly representable coordinates against a double store
+bool pointStoreHalfTest() {
+	int test, i, j, dim, size;
+	SPPoint points[RANDOM_TESTS_SIZE_RANGE];
+	SPPoint query;
+	double out[RANDOM_TESTS_SIZE_RANGE];
+	double halfOut[RANDOM_TESTS_SIZE_RANGE];
+	double data[RANDOM_TESTS_DIM_RANGE];
+	SPPointStore store, halfStore;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % RANDOM_TESTS_DIM_RANGE;
+		size = 1 + rand() % RANDOM_TESTS_SIZE_RANGE;
+		//small integers are exact in half precision, and so are their distances in single precision
+		for (i = 0; i <= size; i++) {
+			for (j = 0; j < dim; j++) {
+				data[j] = (double) (rand() % 17 - 8);
+			}
+			if (i < size) {
+				points[i] = spPointCreate(data, dim, i);
+			} else {
+				query = spPointCreate(data, dim, 0);
+			}
+		}
+		store = spPointStoreCreate(points, size);
+		halfStore = spPointStoreCreateWithPrecision(points, size, SP_POINT_STORE_HALF);
+		ASSERT_TRUE(store != NULL && halfStore != NULL);
+		ASSERT_TRUE(spPointStoreGetPrecision(store) == SP_POINT_STORE_DOUBLE);
+		ASSERT_TRUE(spPointStoreGetPrecision(halfStore) == SP_POINT_STORE_HALF);
+		ASSERT_TRUE(spPointStoreGetSize(halfStore) == size);
+		ASSERT_TRUE(spPointStoreGetDimension(halfStore) == dim);
+		spPointStoreL2SquaredDistanceMany(store, query, out);
+		spPointStoreL2SquaredDistanceMany(halfStore, query, halfOut);
+		for (i = 0; i < size; i++) {
+			ASSERT_TRUE(spPointStoreGetIndex(halfStore, i) == i);
+			ASSERT_TRUE(spPointStoreGetSquaredNorm(halfStore, i) == spPointStoreGetSquaredNorm(store, i));
+			ASSERT_TRUE(halfOut[i] == out[i]);
+			for (j = 0; j < dim; j++) {
+				ASSERT_TRUE(spPointStoreGetAxisCoor(halfStore, i, j) == spPointGetAxisCoor(points[i], j));
+			}
+		}
+		//the matrix kernel has no half precision rows to read
+		ASSERT_TRUE(!spPointStoreL2SquaredDistanceMatrix(store, 0, size, halfStore, out));
+		ASSERT_TRUE(!spPointStoreL2SquaredDistanceMatrix(halfStore, 0, size, store, out));
+		for (i = 0; i < size; i++) {
+			spPointDestroy(points[i]);
+		}
+		spPointDestroy(query);
+		spPointStoreDestroy(store);
+		spPointStoreDestroy(halfStore);
+	}
+	data[0] = 0.1;
+	query = spPointCreate(data, 1, 0);
+	halfStore = spPointStoreCreateWithPrecision(&query, 1, SP_POINT_STORE_HALF);
+	ASSERT_TRUE(spPointStoreGetAxisCoor(halfStore, 0, 0) == 0x1.998p-4); //0.1 rounded to half
+	ASSERT_TRUE(spPointStoreCreateWithPrecision(&query, 1, (SP_POINT_STORE_PRECISION) 7) == NULL);
+	spPointStoreDestroy(halfStore);
+	spPointDestroy(query);
+	return true;
+}
+
+int main() {
+	srand(0);
+	RUN_TEST(pointStoreCreateTest);
+	RUN_TEST(pointStoreCreateInvalidArgumentsTest);
+	RUN_TEST(pointStoreL2SquaredDistanceManyTest);
+	RUN_TEST(pointStoreL2SquaredDistanceMatrixTest);
+	RUN_TEST(pointStoreHalfTest);
+	return 0;
+}
@@ -230,6 +230,236 @@ bool pointDestroyInvalidArgumentsTest() {
 	return true;
 }
 
+//checks that a point does not depend on the array it was created from, and
+//that copies of a high dimension point hold all of its coordinates
+bool pointCreateIndependentDataTest() {
+	int i;
+	int dim = 1000;
+	SPPoint p, q;
+	double* data = (double*)calloc(dim, sizeof(double));
+	ASSERT_TRUE(data != NULL);
+	for (i = 0; i < dim; i++) {
+		data[i] = i * 0.5;
+	}
+	p = spPointCreate(data, dim, 3);
+	for (i = 0; i < dim; i++) {
+		data[i] = -1.0;
+	}
+	free(data);
+	q = spPointCopy(p);
+	ASSERT_TRUE(p != NULL && q != NULL);
+	ASSERT_TRUE(spPointGetIndex(q) == 3 && spPointGetDimension(q) == dim);
+	for (i = 0; i < dim; i++) {
+		ASSERT_TRUE(spPointGetAxisCoor(p, i) == i * 0.5);
+		ASSERT_TRUE(spPointGetAxisCoor(q, i) == i * 0.5);
+	}
+	ASSERT_TRUE(spPointL2SquaredDistance(p, q) == 0.0);
+	spPointDestroy(p);
+	spPointDestroy(q);
+	return true;
+}
+
+//counts the calls of the destructor of an owned point
+void countingDestructor(double* data, void* context) {
+	(*(int*)context)++;
+	free(data);
+}
+
+//checks that an owned point uses the given array and releases it on destroy
+bool pointCreateOwnedTest() {
+	int i, destroyed = 0;
+	int dim = 3;
+	double* data = (double*)malloc(dim * sizeof(double));
+	SPPoint p, q;
+	ASSERT_TRUE(data != NULL);
+	for (i = 0; i < dim; i++) {
+		data[i] = i + 1.5;
+	}
+	p = spPointCreateOwned(data, dim, 2, countingDestructor, &destroyed);
+	ASSERT_TRUE(p != NULL);
+	ASSERT_TRUE(spPointGetIndex(p) == 2 && spPointGetDimension(p) == dim);
+	q = spPointCopy(p);
+	for (i = 0; i < dim; i++) {
+		ASSERT_TRUE(spPointGetAxisCoor(p, i) == i + 1.5);
+		ASSERT_TRUE(spPointGetAxisCoor(q, i) == i + 1.5);
+	}
+	spPointDestroy(p);
+	ASSERT_TRUE(destroyed == 1);
+	ASSERT_TRUE(spPointGetAxisCoor(q, 0) == 1.5);
+	spPointDestroy(q);
+	ASSERT_TRUE(destroyed == 1);
+
+	//released by free when no destructor is given
+	data = (double*)malloc(dim * sizeof(double));
+	ASSERT_TRUE(data != NULL);
+	p = spPointCreateOwned(data, dim, 0, NULL, NULL);
+	ASSERT_TRUE(p != NULL);
+	spPointDestroy(p);
+
+	//invalid arguments, the array is not adopted
+	data = (double*)malloc(dim * sizeof(double));
+	ASSERT_TRUE(data != NULL);
+	ASSERT_TRUE(spPointCreateOwned(NULL, dim, 0, NULL, NULL) == NULL);
+	ASSERT_TRUE(spPointCreateOwned(data, 0, 0, countingDestructor, &destroyed) == NULL);
+	ASSERT_TRUE(spPointCreateOwned(data, dim, -1, countingDestructor, &destroyed) == NULL);
+	ASSERT_TRUE(destroyed == 1);
+	free(data);
+	return true;
+}
+
+//checks that a view point sees the borrowed array and does not release it
+bool pointCreateViewTest() {
+	double data[3] = { 1.0 , 2.0 , 3.0 };
+	SPPoint p = spPointCreateView(data, 3, 7);
+	SPPoint q = spPointCreate(data, 3, 7);
+	SPPoint copy;
+	ASSERT_TRUE(p != NULL && q != NULL);
+	ASSERT_TRUE(spPointGetIndex(p) == 7 && spPointGetDimension(p) == 3);
+	ASSERT_TRUE(spPointL2SquaredDistance(p, q) == 0.0);
+	copy = spPointCopy(p);
+	data[1] = 4.0;
+	ASSERT_TRUE(spPointGetAxisCoor(p, 1) == 4.0);
+	ASSERT_TRUE(spPointGetAxisCoor(copy, 1) == 2.0);
+	ASSERT_TRUE(spPointL2SquaredDistance(p, q) == 4.0);
+	spPointDestroy(p);
+	ASSERT_TRUE(data[0] == 1.0 && data[2] == 3.0);
+	spPointDestroy(q);
+	spPointDestroy(copy);
+
+	ASSERT_TRUE(spPointCreateView(NULL, 3, 7) == NULL);
+	ASSERT_TRUE(spPointCreateView(data, 0, 7) == NULL);
+	ASSERT_TRUE(spPointCreateView(data, 3, -1) == NULL);
+	return true;
+}
+
+//checks that a batch holds the rows of the matrix and is released together
+bool pointCreateBatchTest() {
+	int i, j;
+	double matrix[12] = { 1.0 , 2.0 , 3.0 , 4.0 , 5.0 , 6.0 , 7.0 , 8.0 , 9.0 , 10.0 , 11.0 , 12.0 };
+	int indices[4] = { 9 , 3 , 0 , 3 };
+	SPPoint points[4];
+	SPPoint copy;
+	ASSERT_TRUE(spPointCreateBatch(matrix, 4, 3, indices, points));
+	matrix[0] = -1.0;
+	for (i = 0; i < 4; i++) {
+		ASSERT_TRUE(spPointGetIndex(points[i]) == indices[i]);
+		ASSERT_TRUE(spPointGetDimension(points[i]) == 3);
+		for (j = 0; j < 3; j++) {
+			ASSERT_TRUE(spPointGetAxisCoor(points[i], j) == i * 3 + j + 1.0);
+		}
+	}
+	ASSERT_TRUE(spPointL2SquaredDistance(points[0], points[1]) == 27.0);
+	copy = spPointCopy(points[2]);
+	spPointDestroy(points[2]); //does nothing
+	ASSERT_TRUE(spPointGetAxisCoor(points[2], 0) == 7.0);
+	spPointDestroyBatch(points, 4);
+	ASSERT_TRUE(points[0] == NULL && points[3] == NULL);
+	ASSERT_TRUE(spPointGetAxisCoor(copy, 2) == 9.0);
+	spPointDestroy(copy);
+
+	//default indices, destroyed in any order
+	ASSERT_TRUE(spPointCreateBatch(matrix, 4, 3, NULL, points));
+	ASSERT_TRUE(spPointGetIndex(points[3]) == 3);
+	copy = points[0];
+	points[0] = points[3];
+	points[3] = copy;
+	spPointDestroyBatch(points, 4);
+	return true;
+}
+
+//checks for correct handling of invalid batch arguments
+bool pointCreateBatchInvalidArgumentsTest() {
+	double matrix[4] = { 1.0 , 2.0 , 3.0 , 4.0 };
+	int indices[2] = { 0 , -1 };
+	SPPoint points[2] = { NULL , NULL };
+	ASSERT_FALSE(spPointCreateBatch(NULL, 2, 2, NULL, points));
+	ASSERT_FALSE(spPointCreateBatch(matrix, 0, 2, NULL, points));
+	ASSERT_FALSE(spPointCreateBatch(matrix, 2, 0, NULL, points));
+	ASSERT_FALSE(spPointCreateBatch(matrix, 2, 2, NULL, NULL));
+	ASSERT_FALSE(spPointCreateBatch(matrix, 2, 2, indices, points));
+	ASSERT_TRUE(points[0] == NULL && points[1] == NULL);
+	spPointDestroyBatch(NULL, 2);
+	spPointDestroyBatch(points, 0);
+	return true;
+}
+
+//checks that the distances to many points match the pairwise distances
+bool pointL2SquaredDistanceManyTest() {
+	int test, i, dim, n;
+	SPPoint points[RANDOM_TESTS_DIM_RANGE];
+	double out[RANDOM_TESTS_DIM_RANGE];
+	SPPoint q;
+	for (test = 0; test < RANDOM_TESTS_COUNT; test++) {
+		dim = 1 + rand() % (RANDOM_TESTS_DIM_RANGE * 10);
+		n = rand() % RANDOM_TESTS_DIM_RANGE;
+		for (i = 0; i < n; i++) {
+			points[i] = getRandomPoint(dim);
+		}
+		q = getRandomPoint(dim);
+		spPointL2SquaredDistanceMany(q, points, n, out);
+		for (i = 0; i < n; i++) {
+			ASSERT_TRUE(out[i] - spPointL2SquaredDistance(q, points[i]) < epsilon
+					&& out[i] - spPointL2SquaredDistance(q, points[i]) > -epsilon);
+			spPointDestroy(points[i]);
+		}
+		spPointDestroy(q);
+	}
+	return true;
+}
+
+//checks that the cached squared norms of every kind of point are their squared norms
+bool pointGetSquaredNormTest() {
+	double data[3] = { 1.0 , 2.0 , 3.0 };
+	double matrix[6] = { 1.0 , 2.0 , 3.0 , 0.0 , -4.0 , 0.5 };
+	double* owned = (double*)malloc(3 * sizeof(double));
+	SPPoint batch[2];
+	SPPoint p = spPointCreate(data, 3, 0);
+	SPPoint view = spPointCreateView(data, 3, 1);
+	SPPoint q;
+	ASSERT_TRUE(owned != NULL);
+	owned[0] = 2.0;
+	owned[1] = 0.0;
+	owned[2] = -1.0;
+	q = spPointCreateOwned(owned, 3, 2, NULL, NULL);
+	ASSERT_TRUE(spPointGetSquaredNorm(p) == 14.0);
+	ASSERT_TRUE(spPointGetSquaredNorm(q) == 5.0);
+	ASSERT_TRUE(spPointGetSquaredNorm(view) == 14.0);
+	data[0] = 0.0;
+	ASSERT_TRUE(spPointGetSquaredNorm(view) == 13.0);
+	ASSERT_TRUE(spPointGetSquaredNorm(p) == 14.0);
+	ASSERT_TRUE(spPointCreateBatch(matrix, 2, 3, NULL, batch));
+	ASSERT_TRUE(spPointGetSquaredNorm(batch[0]) == 14.0);
+	ASSERT_TRUE(spPointGetSquaredNorm(batch[1]) == 16.25);
+	spPointDestroyBatch(batch, 2);
+	spPointDestroy(p);
+	spPointDestroy(q);
+	spPointDestroy(view);
+	return true;
+}
+
+//checks the L1 distance, the inner product and the cosine distance of points
+bool pointOtherMetricsTest() {
+	double data1[3] = { 1.0 , -2.0 , 2.0 };
+	double data2[3] = { 2.0 , 1.0 , 0.0 };
+	double data3[3] = { -2.0 , 4.0 , -4.0 };
+	SPPoint p = spPointCreate(data1, 3, 0);
+	SPPoint q = spPointCreate(data2, 3, 1);
+	SPPoint r = spPointCreate(data3, 3, 2);
+	ASSERT_TRUE(spPointL1Distance(p, q) == 6.0);
+	ASSERT_TRUE(spPointL1Distance(q, p) == 6.0);
+	ASSERT_TRUE(spPointL1Distance(p, p) == 0.0);
+	ASSERT_TRUE(spPointInnerProduct(p, q) == 0.0);
+	ASSERT_TRUE(spPointInnerProduct(p, r) == -18.0);
+	ASSERT_TRUE(spPointCosineDistance(p, q) == 1.0);
+	ASSERT_TRUE(spPointCosineDistance(p, r) == 2.0);
+	ASSERT_TRUE(spPointCosineDistance(r, p) == 2.0);
+	ASSERT_TRUE(spPointCosineDistance(p, p) < epsilon);
+	spPointDestroy(p);
+	spPointDestroy(q);
+	spPointDestroy(r);
+	return true;
+}
+
 int main() {
 	RUN_TEST(pointBasicCopyTest);
 	RUN_TEST(pointBasicL2Distance);
@@ -242,6 +472,14 @@ int main() {
 	RUN_TEST(pointTestTriangleInequality);
 	RUN_TEST(pointTestDistanceSymmetric);
 	RUN_TEST(pointTestDistanceNotNegative);
+	RUN_TEST(pointCreateIndependentDataTest);
+	RUN_TEST(pointCreateOwnedTest);
+	RUN_TEST(pointCreateViewTest);
+	RUN_TEST(pointCreateBatchTest);
+	RUN_TEST(pointCreateBatchInvalidArgumentsTest);
+	RUN_TEST(pointL2SquaredDistanceManyTest);
+	RUN_TEST(pointGetSquaredNormTest);
+	RUN_TEST(pointOtherMetricsTest);
 
 	return 0;
 }